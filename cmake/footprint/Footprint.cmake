@@ -0,0 +1,152 @@
+#=============================================================================#
+# Firmware footprint and timing budget report (run with cmake -P)
+#
+#        FIRMWARE_IMAGE  - Firmware image (.elf)
+#        PROBE_DIR       - Directory containing compiled heap probe object
+#        STACK_USAGE_DIR - Directory containing stack usage files (.su) of firmware (FOOTPRINT_STACK_USAGE=ON)
+#        AVRSIZE_PROGRAM - avr-size program
+#        AVRNM_PROGRAM   - avr-nm program
+#        FLASH_BUDGET    - Max flash (bytes): .text + .data
+#        SRAM_BUDGET     - Max SRAM (bytes): .data + .bss + .noinit + estimated heap
+#                          (heap estimate covers TimeSwitchApplication::construct() only, hand-maintained:
+#                          cross-check with heap measured at boot, BOOT report)
+#        SYMBOL_COUNT    - Number of biggest symbols displayed by region
+#        REPORT_FILE     - Full report output file
+#
+# Fails if a budget is exceeded.
+#=============================================================================#
+
+if (NOT SYMBOL_COUNT)
+    set(SYMBOL_COUNT 15)
+endif()
+
+set(REPORT "")
+macro(REPORT_LINE LINE)
+    message("${LINE}")
+    set(REPORT "${REPORT}${LINE}\n")
+endmacro()
+
+#
+# Sections
+#
+execute_process(COMMAND ${AVRSIZE_PROGRAM} -A ${FIRMWARE_IMAGE} OUTPUT_VARIABLE SIZE_OUTPUT)
+string(REPLACE "\n" ";" SIZE_LINES "${SIZE_OUTPUT}")
+foreach (SECTION text data bss noinit)
+    set(SECTION_${SECTION} 0)
+endforeach()
+foreach (LINE ${SIZE_LINES})
+    if ("${LINE}" MATCHES "^\\.(text|data|bss|noinit)[ \t]+([0-9]+)")
+        set(SECTION_${CMAKE_MATCH_1} ${CMAKE_MATCH_2})
+    endif()
+endforeach()
+math(EXPR FLASH_USED "${SECTION_text} + ${SECTION_data}")
+math(EXPR SRAM_STATIC "${SECTION_data} + ${SECTION_bss} + ${SECTION_noinit}")
+
+#
+# Symbols (biggest first)
+#
+execute_process(COMMAND ${AVRNM_PROGRAM} -C -S --size-sort -r ${FIRMWARE_IMAGE} OUTPUT_VARIABLE NM_OUTPUT)
+string(REPLACE ";" "," NM_OUTPUT "${NM_OUTPUT}")
+string(REPLACE "\n" ";" NM_LINES "${NM_OUTPUT}")
+set(FLASH_SYMBOLS "")
+set(SRAM_SYMBOLS "")
+set(ALL_SYMBOLS "")
+set(DATA_NAMED 0)
+foreach (LINE ${NM_LINES})
+    if ("${LINE}" MATCHES "^[0-9a-fA-F]+ ([0-9a-fA-F]+) ([a-zA-Z]) (.*)$")
+        set(SYMBOL_TYPE ${CMAKE_MATCH_2})
+        set(SYMBOL_NAME "${CMAKE_MATCH_3}")
+        math(EXPR SYMBOL_SIZE "0x${CMAKE_MATCH_1}")
+        set(ALL_SYMBOLS "${ALL_SYMBOLS}  ${SYMBOL_SIZE}\t${SYMBOL_TYPE}\t${SYMBOL_NAME}\n")
+        # Code and read-only data: flash. Initialized data: flash and SRAM. Uninitialized data: SRAM
+        if ("${SYMBOL_TYPE}" MATCHES "^[TtWwRr]$")
+            list(APPEND FLASH_SYMBOLS "${SYMBOL_SIZE}\t${SYMBOL_NAME}")
+        elseif ("${SYMBOL_TYPE}" MATCHES "^[Dd]$")
+            list(APPEND FLASH_SYMBOLS "${SYMBOL_SIZE}\t${SYMBOL_NAME} (.data)")
+            list(APPEND SRAM_SYMBOLS "${SYMBOL_SIZE}\t${SYMBOL_NAME} (.data)")
+            math(EXPR DATA_NAMED "${DATA_NAMED} + ${SYMBOL_SIZE}")
+        elseif ("${SYMBOL_TYPE}" MATCHES "^[BbVv]$")
+            list(APPEND SRAM_SYMBOLS "${SYMBOL_SIZE}\t${SYMBOL_NAME}")
+        endif()
+    endif()
+endforeach()
+# Anonymous initialized data (string literals not in flash with F()/PSTR, padding)
+math(EXPR DATA_UNATTRIBUTED "${SECTION_data} - ${DATA_NAMED}")
+
+#
+# Heap reserved by construct() (probe)
+#
+file(GLOB_RECURSE PROBE_OBJECTS "${PROBE_DIR}/*HeapProbe.cpp*")
+set(HEAP_ESTIMATE 0)
+set(HEAP_SYMBOLS "")
+foreach (PROBE_OBJECT ${PROBE_OBJECTS})
+    if (NOT "${PROBE_OBJECT}" MATCHES "\\.(d|su)$")
+        execute_process(COMMAND ${AVRNM_PROGRAM} -S ${PROBE_OBJECT} OUTPUT_VARIABLE PROBE_OUTPUT)
+        string(REPLACE "\n" ";" PROBE_LINES "${PROBE_OUTPUT}")
+        foreach (LINE ${PROBE_LINES})
+            if ("${LINE}" MATCHES "^[0-9a-fA-F]+ ([0-9a-fA-F]+) [a-zA-Z] footprint_heap_(.*)$")
+                math(EXPR SYMBOL_SIZE "0x${CMAKE_MATCH_1}")
+                math(EXPR HEAP_ESTIMATE "${HEAP_ESTIMATE} + ${SYMBOL_SIZE}")
+                list(APPEND HEAP_SYMBOLS "${SYMBOL_SIZE}\t${CMAKE_MATCH_2}")
+            endif()
+        endforeach()
+    endif()
+endforeach()
+math(EXPR SRAM_USED "${SRAM_STATIC} + ${HEAP_ESTIMATE}")
+
+#
+# Stack usage of main process functions
+#
+file(GLOB_RECURSE STACK_USAGE_FILES "${STACK_USAGE_DIR}/*.su")
+set(STACK_USAGES "")
+foreach (STACK_USAGE_FILE ${STACK_USAGE_FILES})
+    file(STRINGS ${STACK_USAGE_FILE} STACK_USAGE_LINES REGEX "(::process\\(\\)|::processPacket\\()")
+    foreach (LINE ${STACK_USAGE_LINES})
+        if ("${LINE}" MATCHES "^[^:]*:[0-9]+:[0-9]+:([^\t]+)\t([0-9]+)\t(.*)$")
+            list(APPEND STACK_USAGES "${CMAKE_MATCH_2}\t${CMAKE_MATCH_3}\t${CMAKE_MATCH_1}")
+        endif()
+    endforeach()
+endforeach()
+
+#
+# Report
+#
+REPORT_LINE("Flash: ${FLASH_USED} / ${FLASH_BUDGET} bytes (.text ${SECTION_text}, .data ${SECTION_data})")
+REPORT_LINE("SRAM:  ${SRAM_USED} / ${SRAM_BUDGET} bytes (.data ${SECTION_data}, .bss ${SECTION_bss}, .noinit ${SECTION_noinit}, construct() heap estimate ${HEAP_ESTIMATE})")
+REPORT_LINE("Unattributed .data (string literals, padding): ${DATA_UNATTRIBUTED} bytes")
+
+function(REPORT_LIST TITLE LIST_NAME LIMIT)
+    REPORT_LINE("${TITLE}")
+    set(INDEX 0)
+    foreach (ITEM ${${LIST_NAME}})
+        if (${INDEX} LESS ${LIMIT})
+            REPORT_LINE("  ${ITEM}")
+        endif()
+        math(EXPR INDEX "${INDEX} + 1")
+    endforeach()
+    set(REPORT "${REPORT}" PARENT_SCOPE)
+endfunction()
+
+REPORT_LIST("Biggest flash symbols:" FLASH_SYMBOLS ${SYMBOL_COUNT})
+REPORT_LIST("Biggest SRAM symbols:" SRAM_SYMBOLS ${SYMBOL_COUNT})
+REPORT_LIST("Heap reserved by construct(), estimate (excludes ArduinoApplication base, setup() and per-loop allocations; compare with BOOT report):" HEAP_SYMBOLS 1000)
+if (STACK_USAGE_FILES)
+    REPORT_LIST("Stack usage (bytes, qualifier, function):" STACK_USAGES 1000)
+else()
+    REPORT_LINE("Stack usage: not available, configure with -DFOOTPRINT_STACK_USAGE=ON")
+endif()
+
+if (REPORT_FILE)
+    file(WRITE ${REPORT_FILE} "${REPORT}\nAll symbols (size, type, name):\n${ALL_SYMBOLS}")
+    message("Full report: ${REPORT_FILE}")
+endif()
+
+#
+# Budgets
+#
+if (FLASH_BUDGET AND FLASH_USED GREATER FLASH_BUDGET)
+    message(FATAL_ERROR "Flash budget exceeded: ${FLASH_USED} > ${FLASH_BUDGET} bytes")
+endif()
+if (SRAM_BUDGET AND SRAM_USED GREATER SRAM_BUDGET)
+    message(FATAL_ERROR "SRAM budget exceeded: ${SRAM_USED} > ${SRAM_BUDGET} bytes")
+endif()
@@ -0,0 +1,34 @@
+//
+// Heap probe: compiled (never linked) by footprint target.
+// Each symbol size is the heap reserved by an allocation of TimeSwitchApplication::construct(),
+// including malloc header (2 bytes by block). Hand-maintained estimate: cross-check it against
+// heap measured by construct() itself (BOOT report, serial "Heap reserved by construct").
+// Not covered: ArduinoApplication base properties, transmit state and requester allocated
+// during setup(), packets allocated at each loop.
+//
+
+#include <Arduino.h>
+#include <com/osteres/automation/actuator/timeswitch/TimeSwitchApplication.h>
+
+#define FOOTPRINT_HEAP(name, type, count) extern char const footprint_heap_##name[(sizeof(type) + 2) * (count)] = {0};
+
+// PowerControl and its pin properties
+FOOTPRINT_HEAP(PowerControl, PowerControl, 1)
+FOOTPRINT_HEAP(PinProperty, PinProperty<unsigned int>, 5)
+
+// Stored properties: shutdown delay, overcurrent limit, calibration offset / journal state / histogram packs
+FOOTPRINT_HEAP(StoredPropertyUInt, StoredProperty<unsigned int>, 3)
+FOOTPRINT_HEAP(StoredPropertyUChar, StoredProperty<unsigned char>, 1)
+FOOTPRINT_HEAP(StoredPropertyULong, StoredProperty<unsigned long>, SHUTDOWN_HISTOGRAM_PACKS)
+
+// Components
+FOOTPRINT_HEAP(ShutdownBuffer, ShutdownBuffer, 1)
+FOOTPRINT_HEAP(StateJournal, StateJournal, 1)
+FOOTPRINT_HEAP(OvercurrentProtection, OvercurrentProtection, 1)
+FOOTPRINT_HEAP(CurrentSensorCalibration, CurrentSensorCalibration, 1)
+FOOTPRINT_HEAP(ShutdownStatistics, ShutdownStatistics, 1)
+FOOTPRINT_HEAP(Watchdog, Watchdog, 1)
+FOOTPRINT_HEAP(LinkMonitor, LinkMonitor, 1)
+
+// Actions
+FOOTPRINT_HEAP(ActionManager, ActionManager, 1)
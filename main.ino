@@ -1,17 +1,16 @@
 
 #include <Arduino.h>
-#include <StandardCplusplus.h>
 #include <SPI.h>
 #include "RF24/nRF24L01.h"
 #include <RF24/RF24.h>
 #include <com/osteres/automation/actuator/timeswitch/TimeSwitchApplication.h>
 #include <com/osteres/automation/transmission/Transmitter.h>
-#include <com/osteres/automation/arduino/transmission/ArduinoRequester.h>
+#include <com/osteres/automation/actuator/timeswitch/transmission/MonitoredRequester.h>
 
 
 using com::osteres::automation::actuator::timeswitch::TimeSwitchApplication;
 using com::osteres::automation::transmission::Transmitter;
-using com::osteres::automation::arduino::transmission::ArduinoRequester;
+using com::osteres::automation::actuator::timeswitch::transmission::MonitoredRequester;
 using com::osteres::automation::transmission::packet::Packet;
 using com::osteres::automation::transmission::packet::Command;
 
@@ -31,11 +30,19 @@ using com::osteres::automation::transmission::packet::Command;
 #define PIN_SWITCH_LOCK_POWER_ON 2
 // Input digital pin for auto mode configuration (1 -> auto mode enable, 0 -> nothing)
 #define PIN_SWITCH_AUTO_MODE 3
+// Analog comparator (fixed pins): D6 (AIN0) current sensor output, D7 (AIN1) overcurrent reference voltage
+// Sensor output falling with load current: reference = Vcc/2 - limit (A) * 0.185V, e.g. 2.5V - 3A * 0.185V = 1.945V
+// Sensor output rising with load current: reference = Vcc/2 + limit (A) * 0.185V, e.g. 2.5V + 3A * 0.185V = 3.055V
 
 /**
  * Configuration
  */
-// Nothing
+// Overcurrent fast path by analog comparator (only if D6/D7 wired, see above)
+#define OVERCURRENT_COMPARATOR false
+// Sensor output falls below Vcc/2 with load current (true), or rises above (false), see reference above
+#define OVERCURRENT_SENSOR_FALLING true
+// Request channel hop to master when link is too poor (master must support CONFIG channel)
+#define LINK_CHANNEL_HOPPING false
 
 /*
  * Prepare electronic component
@@ -64,12 +71,26 @@ TimeSwitchApplication application(
 void setup() {
     Serial.begin(9600);
 
-    // Set requester manually
-    transmitter.setRequester(new ArduinoRequester(transmitter.getRadio(), transmitter.getWritingChannel()));
+    // Supervise boot (radio setup included)
+    application.getWatchdog()->boot();
+
+    // Set requester manually (result of each packet sent recorded for link quality)
+    transmitter.setRequester(new MonitoredRequester(
+        transmitter.getRadio(),
+        transmitter.getWritingChannel(),
+        application.getLinkMonitor()
+    ));
 
     // Setup transmitter
     transmitter.setup();
 
+    // Overcurrent fast path
+    application.getOvercurrentProtection()->setEnabled(OVERCURRENT_COMPARATOR);
+    application.getOvercurrentProtection()->setFalling(OVERCURRENT_SENSOR_FALLING);
+
+    // Radio link channel hopping
+    application.getLinkMonitor()->setHoppingEnabled(LINK_CHANNEL_HOPPING);
+
     // Setup (configuration)
     application.setup();
 }
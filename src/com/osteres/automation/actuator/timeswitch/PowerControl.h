@@ -6,16 +6,25 @@
 #define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_POWERCONTROL_H
 
 #define ACS712_RAPPORT 0.185 // V per A
+#define POWER_CONTROL_LISTENER_MAX 4 // Max listeners notified on state change
+#define CURRENT_SENSOR_SAMPLES 10 // ADC samples per current measure (1 ADC count ~ 26mA)
+#define CURRENT_ON_THRESHOLD 140 // Current (mA) to consider device power on (hysteresis above off threshold)
+#define CURRENT_OFF_THRESHOLD 100 // Current (mA) under which device is considered power off (shutdown complete)
+#define CALIBRATION_SETTLE_DELAY 1000 // Time (ms) after power off before learning sensor offset
+#define OVERCURRENT_BLANKING_DELAY 200 // Time (ms) after power on during which comparator trips are ignored (inrush current)
 
 #include <Arduino.h>
-#include <StandardCplusplus.h>
-#include <string>
 #include <com/osteres/automation/arduino/memory/PinProperty.h>
 #include <com/osteres/arduino/util/VccReader.h>
+#include <com/osteres/automation/actuator/timeswitch/PowerControlListener.h>
+#include <com/osteres/automation/actuator/timeswitch/component/CurrentSensorCalibration.h>
+#include <com/osteres/automation/actuator/timeswitch/component/ShutdownStatistics.h>
 
 using com::osteres::automation::arduino::memory::PinProperty;
 using com::osteres::arduino::util::VccReader;
-using std::string;
+using com::osteres::automation::actuator::timeswitch::PowerControlListener;
+using com::osteres::automation::actuator::timeswitch::component::CurrentSensorCalibration;
+using com::osteres::automation::actuator::timeswitch::component::ShutdownStatistics;
 
 namespace com
 {
@@ -30,6 +39,16 @@ namespace com
                     class PowerControl
                     {
                     public:
+                        /**
+                         * Fault source: analog comparator (fast path, interrupt)
+                         */
+                        static unsigned char const FAULT_COMPARATOR = 1;
+
+                        /**
+                         * Fault source: current measure (slow path, loop)
+                         */
+                        static unsigned char const FAULT_MEASURE = 2;
+
                         /**
                          * Constructor
                          */
@@ -79,6 +98,16 @@ namespace com
                                 delete this->switchAutoModeProperty;
                                 this->switchAutoModeProperty = NULL;
                             }
+                            // Remove current sensor calibration
+                            if (this->calibration != NULL) {
+                                delete this->calibration;
+                                this->calibration = NULL;
+                            }
+                            // Remove shutdown statistics
+                            if (this->shutdownStatistics != NULL) {
+                                delete this->shutdownStatistics;
+                                this->shutdownStatistics = NULL;
+                            }
                         }
 
                         /**
@@ -86,15 +115,34 @@ namespace com
                          * 1. Enable shutdown command
                          * 2. Wait current consumption falls
                          * 3. Power off output
+                         * Once requested, current is checked sparsely until expected completion (learned durations),
+                         * overcurrent (slow path) is still checked each call
                          */
                         void securePowerOff()
                         {
-                            Serial.println("Secure power off or check to terminate process");
-                            // Enable shutdown command
-                            this->getShutdownCommandProperty()->set(1);
+                            unsigned long now = millis();
+                            ShutdownStatistics * statistics = this->getShutdownStatistics();
 
-                            // Flag to indicate that shutdown has been requested
-                            this->setShutdownRequested(true);
+                            if (!this->isShutdownRequested()) {
+                                Serial.println(F("Secure power off"));
+                                // Enable shutdown command
+                                this->getShutdownCommandProperty()->set(1);
+
+                                this->shutdownStartTime = now;
+                                this->shutdownTimed = true;
+                                this->shutdownAnomaly = false;
+                            }
+                            // Check to terminate process, when scheduled only
+                            else if (
+                                statistics != NULL &&
+                                this->shutdownTimed &&
+                                now - this->shutdownCheckTime < statistics->getCheckInterval(now - this->shutdownStartTime)
+                            ) {
+                                // Overcurrent not scheduled
+                                this->readCurrent();
+                                return;
+                            }
+                            this->shutdownCheckTime = now;
 
                             // Wait current consumption falls
                             if (!this->isReallyPowerOn()) {
@@ -103,9 +151,31 @@ namespace com
 
                                 // Reinit shutdown command
                                 this->getShutdownCommandProperty()->set(0);
+                                this->powerOffTime = now;
+                                this->powerOffKnown = true;
 
-                                this->setShutdownRequested(false);
-                                this->setOutputState(false);
+                                // Learn shutdown duration (unknown if shutdown resumed after reset)
+                                if (statistics != NULL && this->shutdownTimed) {
+                                    statistics->record(now - this->shutdownStartTime);
+                                }
+                                this->shutdownTimed = false;
+
+                                this->changeState(false, false);
+                            }
+                            // Abnormally long shutdown (above learned p99): notify once
+                            else if (
+                                statistics != NULL &&
+                                this->shutdownTimed &&
+                                !this->shutdownAnomaly &&
+                                statistics->isAnomaly(now - this->shutdownStartTime)
+                            ) {
+                                Serial.println(F("Shutdown longer than expected"));
+                                this->shutdownAnomaly = true;
+                                this->notifyListeners();
+                            }
+                            // Flag to indicate that shutdown has been requested
+                            else {
+                                this->changeState(this->getOutputState(), true);
                             }
                         }
 
@@ -114,13 +184,28 @@ namespace com
                          */
                         void powerOn()
                         {
+                            // Fault must be cleared before power on (refusal logged once by fault)
+                            if (this->isFaultLatched()) {
+                                if (!this->faultRefusalLogged) {
+                                    Serial.println(F("Power on refused, fault latched"));
+                                    this->faultRefusalLogged = true;
+                                }
+                                return;
+                            }
+
                             Serial.println("Power on");
 
+                            // Start comparator blanking (read from interrupt)
+                            unsigned long now = millis();
+                            noInterrupts();
+                            this->powerOnTime = now;
+                            this->powerOnBlanking = true;
+                            interrupts();
+
                             this->getPowerOffCommandProperty()->set(0);
                             this->getShutdownCommandProperty()->set(0);
 
-                            this->setShutdownRequested(false);
-                            this->setOutputState(true);
+                            this->changeState(true, false);
                         }
 
                         /**
@@ -131,9 +216,30 @@ namespace com
                             Serial.println("Hard power off");
                             this->getPowerOffCommandProperty()->set(1);
                             this->getShutdownCommandProperty()->set(0);
+                            this->powerOffTime = millis();
+                            this->powerOffKnown = true;
+
+                            this->changeState(false, false);
+                        }
+
+                        /**
+                         * Resume output power on after a controller reset, without toggling power command
+                         */
+                        void resumePowerOn(bool shutdownRequested)
+                        {
+                            // Fault tripped by resume check: output already cut
+                            if (this->isFaultLatched()) {
+                                Serial.println(F("Resume refused, fault latched"));
+                                return;
+                            }
+
+                            Serial.println(shutdownRequested ? F("Resume power on, shutdown pending") : F("Resume power on"));
 
-                            this->setShutdownRequested(false);
-                            this->setOutputState(false);
+                            this->getPowerOffCommandProperty()->set(0);
+                            this->getShutdownCommandProperty()->set(shutdownRequested ? 1 : 0);
+                            this->shutdownTimed = false;
+
+                            this->changeState(true, shutdownRequested);
                         }
 
                         /**
@@ -142,13 +248,184 @@ namespace com
                         bool isReallyPowerOn()
                         {
                             // Calculate current consumption (in mA)
-                            unsigned int vRead = this->getCurrentSensorProperty()->read(10);
+                            float current = this->readCurrent();
+
+                            // Wait current consumption falls (hysteresis to avoid toggling verdict around threshold)
+                            this->reallyPowerOn = current >= (this->reallyPowerOn ? CURRENT_OFF_THRESHOLD : CURRENT_ON_THRESHOLD);
+
+                            return this->reallyPowerOn;
+                        }
+
+                        /**
+                         * Read current consumption (in mA)
+                         * Zero offset learned while output is off, then subtracted.
+                         * Slow overcurrent path: latch fault if current exceed overcurrent limit
+                         */
+                        float readCurrent()
+                        {
+                            unsigned int vRead = this->getCurrentSensorProperty()->read(CURRENT_SENSOR_SAMPLES);
                             float vcc = VccReader::readV();
-                            float halfVcc = vcc/2.0;
-                            float current = abs(round(100 * 1000 * ( halfVcc - ( vcc * vRead / 1023.0 ) ) / ACS712_RAPPORT)) / 100.0;
+                            float offset = 1023 / 2.0;
+
+                            if (this->calibration != NULL) {
+                                // Output known to be off (settled): learn offset
+                                if (
+                                    this->powerOffKnown &&
+                                    !this->getOutputState() &&
+                                    !this->isShutdownRequested() &&
+                                    millis() - this->powerOffTime >= CALIBRATION_SETTLE_DELAY
+                                ) {
+                                    this->calibration->learn(vRead);
+                                }
+                                offset = this->calibration->getOffset();
+                            }
 
-                            // Wait current consumption falls
-                            return current >= 100;
+                            float current = abs(round(100 * 1000 * ( vcc * ( offset - vRead ) / 1023.0 ) / ACS712_RAPPORT)) / 100.0;
+
+                            if (this->overcurrentLimit > 0 && current >= this->overcurrentLimit) {
+                                this->tripFault(PowerControl::FAULT_MEASURE);
+                            }
+
+                            return current;
+                        }
+
+                        /**
+                         * Cut output immediately and latch fault. Safe to call from interrupt:
+                         * only command pins and fault flag are updated, state is updated by handleFault()
+                         * Comparator trips are ignored during OVERCURRENT_BLANKING_DELAY after power on (inrush current)
+                         */
+                        void tripFault(unsigned char source)
+                        {
+                            if (source == PowerControl::FAULT_COMPARATOR && this->isPowerOnBlanking()) {
+                                return;
+                            }
+
+                            this->getPowerOffCommandProperty()->set(1);
+                            this->getShutdownCommandProperty()->set(0);
+
+                            if (this->faultSource == 0) {
+                                this->faultSource = source;
+                            }
+                        }
+
+                        /**
+                         * Update state after fault has been tripped (called from loop)
+                         * Return true if fault has just been handled
+                         */
+                        bool handleFault()
+                        {
+                            if (!this->isFaultLatched() || (!this->getOutputState() && !this->isShutdownRequested())) {
+                                return false;
+                            }
+
+                            Serial.println(F("Overcurrent fault, output cut"));
+
+                            // Command pins could have been changed between trip and now
+                            this->getPowerOffCommandProperty()->set(1);
+                            this->getShutdownCommandProperty()->set(0);
+                            this->powerOffTime = millis();
+                            this->powerOffKnown = true;
+
+                            this->changeState(false, false);
+
+                            return true;
+                        }
+
+                        /**
+                         * Clear latched fault (output stays off until next power on)
+                         */
+                        void clearFault()
+                        {
+                            Serial.println(F("Fault cleared"));
+                            this->faultSource = 0;
+                            this->faultRefusalLogged = false;
+
+                            // State has changed for listeners (fault flag)
+                            this->notifyListeners();
+                        }
+
+                        /**
+                         * Flag to indicate if comparator trips are ignored (inrush current after power on)
+                         */
+                        bool isPowerOnBlanking()
+                        {
+                            if (this->powerOnBlanking && millis() - this->powerOnTime >= OVERCURRENT_BLANKING_DELAY) {
+                                this->powerOnBlanking = false;
+                            }
+
+                            return this->powerOnBlanking;
+                        }
+
+                        /**
+                         * Flag to indicate if a fault is latched
+                         */
+                        bool isFaultLatched()
+                        {
+                            return this->faultSource != 0;
+                        }
+
+                        /**
+                         * Get source of latched fault (FAULT_xxx constant, 0 if none)
+                         */
+                        unsigned char getFaultSource()
+                        {
+                            return this->faultSource;
+                        }
+
+                        /**
+                         * Get current sensor calibration
+                         */
+                        CurrentSensorCalibration * getCalibration()
+                        {
+                            return this->calibration;
+                        }
+
+                        /**
+                         * Set current sensor calibration (power control takes ownership)
+                         */
+                        void setCalibration(CurrentSensorCalibration * calibration)
+                        {
+                            this->calibration = calibration;
+                        }
+
+                        /**
+                         * Get shutdown statistics
+                         */
+                        ShutdownStatistics * getShutdownStatistics()
+                        {
+                            return this->shutdownStatistics;
+                        }
+
+                        /**
+                         * Set shutdown statistics (power control takes ownership)
+                         */
+                        void setShutdownStatistics(ShutdownStatistics * shutdownStatistics)
+                        {
+                            this->shutdownStatistics = shutdownStatistics;
+                        }
+
+                        /**
+                         * Flag to indicate if current shutdown lasts longer than learned p99
+                         */
+                        bool isShutdownAnomaly()
+                        {
+                            return this->isShutdownRequested() && this->shutdownAnomaly;
+                        }
+
+                        /**
+                         * Get overcurrent limit (in mA, 0 to disable slow path)
+                         */
+                        unsigned int getOvercurrentLimit()
+                        {
+                            return this->overcurrentLimit;
+                        }
+
+                        /**
+                         * Set overcurrent limit (in mA, 0 to disable slow path)
+                         */
+                        void setOvercurrentLimit(unsigned int limit)
+                        {
+                            this->overcurrentLimit = limit;
                         }
 
                         /**
@@ -239,8 +516,47 @@ namespace com
                             this->shutdownRequested = flag;
                         }
 
+                        /**
+                         * Register a listener notified on each state change (no allocation)
+                         * Return false if maximum of listeners is reached
+                         */
+                        bool addListener(PowerControlListener * listener)
+                        {
+                            if (this->listenerCount >= POWER_CONTROL_LISTENER_MAX) {
+                                return false;
+                            }
+                            this->listeners[this->listenerCount++] = listener;
+
+                            return true;
+                        }
+
                     protected:
 
+                        /**
+                         * Update output state and shutdown request flag, then notify listeners if changed
+                         */
+                        void changeState(bool outputState, bool shutdownRequested)
+                        {
+                            bool changed = this->getOutputState() != outputState || this->isShutdownRequested() != shutdownRequested;
+
+                            this->setShutdownRequested(shutdownRequested);
+                            this->setOutputState(outputState);
+
+                            if (changed) {
+                                this->notifyListeners();
+                            }
+                        }
+
+                        /**
+                         * Notify all listeners that state has changed
+                         */
+                        void notifyListeners()
+                        {
+                            for (unsigned char i = 0; i < this->listenerCount; i++) {
+                                this->listeners[i]->onStateChange(this);
+                            }
+                        }
+
                         /**
                          * Common part constructor
                          */
@@ -313,6 +629,86 @@ namespace com
                          * Flag to indicate if shutdown has been requested
                          */
                         bool shutdownRequested = false;
+
+                        /**
+                         * Source of latched fault, 0 if none (can be set from interrupt)
+                         */
+                        volatile unsigned char faultSource = 0;
+
+                        /**
+                         * Flag to indicate if power on refusal has been logged for latched fault
+                         */
+                        bool faultRefusalLogged = false;
+
+                        /**
+                         * Time of last power on (in ms), for comparator blanking (read from interrupt)
+                         */
+                        volatile unsigned long powerOnTime = 0;
+
+                        /**
+                         * Flag to indicate if comparator blanking is active after power on
+                         */
+                        volatile bool powerOnBlanking = false;
+
+                        /**
+                         * Overcurrent limit (in mA) for slow path, 0 to disable
+                         */
+                        unsigned int overcurrentLimit = 0;
+
+                        /**
+                         * Current sensor calibration (zero offset)
+                         */
+                        CurrentSensorCalibration * calibration = NULL;
+
+                        /**
+                         * Last verdict of current consumption (hysteresis)
+                         */
+                        bool reallyPowerOn = false;
+
+                        /**
+                         * Time of last power off command (in ms), to learn current sensor offset once settled
+                         */
+                        unsigned long powerOffTime = 0;
+
+                        /**
+                         * Flag to indicate if power off has been commanded since boot (output known to be off)
+                         */
+                        bool powerOffKnown = false;
+
+                        /**
+                         * Shutdown statistics (learned durations)
+                         */
+                        ShutdownStatistics * shutdownStatistics = NULL;
+
+                        /**
+                         * Time of shutdown request (in ms)
+                         */
+                        unsigned long shutdownStartTime = 0;
+
+                        /**
+                         * Time of last current check during shutdown (in ms)
+                         */
+                        unsigned long shutdownCheckTime = 0;
+
+                        /**
+                         * Flag to indicate if shutdown has been requested since boot (duration known)
+                         */
+                        bool shutdownTimed = false;
+
+                        /**
+                         * Flag to indicate if current shutdown lasts longer than expected
+                         */
+                        bool shutdownAnomaly = false;
+
+                        /**
+                         * Listeners notified on state change
+                         */
+                        PowerControlListener * listeners[POWER_CONTROL_LISTENER_MAX];
+
+                        /**
+                         * Number of registered listeners
+                         */
+                        unsigned char listenerCount = 0;
                     };
                 }
             }
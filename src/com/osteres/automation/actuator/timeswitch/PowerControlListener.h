@@ -0,0 +1,35 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_POWERCONTROLLISTENER_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_POWERCONTROLLISTENER_H
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    class PowerControl;
+
+                    class PowerControlListener
+                    {
+                    public:
+                        /**
+                         * Destructor
+                         */
+                        virtual ~PowerControlListener() {}
+
+                        /**
+                         * Called by power control when output state or shutdown request flag change
+                         */
+                        virtual void onStateChange(PowerControl * powerControl) = 0;
+                    };
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_POWERCONTROLLISTENER_H
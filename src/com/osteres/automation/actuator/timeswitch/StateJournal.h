@@ -0,0 +1,203 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_STATEJOURNAL_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_STATEJOURNAL_H
+
+#define STATE_JOURNAL_MARKER 0xA0 // High bits of journaled state (erased EEPROM is 0xFF)
+#define STATE_JOURNAL_MAGIC 0x5354 // Warm record magic number
+
+#include <Arduino.h>
+#include <com/osteres/automation/arduino/memory/StoredProperty.h>
+#include <com/osteres/automation/actuator/timeswitch/PowerControl.h>
+#include <com/osteres/automation/actuator/timeswitch/PowerControlListener.h>
+
+using com::osteres::automation::arduino::memory::StoredProperty;
+using com::osteres::automation::actuator::timeswitch::PowerControl;
+using com::osteres::automation::actuator::timeswitch::PowerControlListener;
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    /**
+                     * Journal record kept in RAM across warm reset
+                     */
+                    struct StateJournalRecord
+                    {
+                        unsigned int magic;
+                        unsigned char state;
+                        unsigned long bufferRemaining;
+                        unsigned char checksum;
+                    };
+
+                    /**
+                     * Journal record, kept out of .bss initialization (survive warm reset)
+                     * Note: header must be included from a single translation unit (sketch)
+                     */
+                    static StateJournalRecord stateJournalRecord __attribute__ ((section (".noinit")));
+
+                    /**
+                     * Journal of power control state, to resume it after a controller reset
+                     * - Output state and shutdown request flag are written to EEPROM on each transition
+                     * - Same state and remaining shutdown buffer time are kept in .noinit RAM (survive warm reset)
+                     */
+                    class StateJournal : public PowerControlListener
+                    {
+                    public:
+                        /**
+                         * Flag for output state
+                         */
+                        static unsigned char const OUTPUT_STATE = 0x01;
+
+                        /**
+                         * Flag for shutdown requested
+                         */
+                        static unsigned char const SHUTDOWN_REQUESTED = 0x02;
+
+                        /**
+                         * Constructor
+                         * Journal takes ownership of state property (configured by caller)
+                         */
+                        StateJournal(StoredProperty<unsigned char> * stateProperty)
+                        {
+                            this->stateProperty = stateProperty;
+
+                            // Read journal before any write
+                            StateJournalRecord * record = &stateJournalRecord;
+                            this->warm = record->magic == STATE_JOURNAL_MAGIC && record->checksum == StateJournal::checksum(record);
+                            if (this->warm) {
+                                this->state = record->state;
+                                this->bufferRemaining = record->bufferRemaining;
+                            } else if ((this->stateProperty->get() & 0xF0) == STATE_JOURNAL_MARKER) {
+                                this->state = this->stateProperty->get() & (OUTPUT_STATE | SHUTDOWN_REQUESTED);
+                            }
+                        }
+
+                        /**
+                         * Destructor
+                         */
+                        virtual ~StateJournal()
+                        {
+                            // Remove state property
+                            if (this->stateProperty != NULL) {
+                                delete this->stateProperty;
+                                this->stateProperty = NULL;
+                            }
+                        }
+
+                        /**
+                         * Power control state changed: journal it
+                         */
+                        virtual void onStateChange(PowerControl * powerControl)
+                        {
+                            this->state = (powerControl->getOutputState() ? OUTPUT_STATE : 0) |
+                                (powerControl->isShutdownRequested() ? SHUTDOWN_REQUESTED : 0);
+
+                            // EEPROM written on transition only (limit wear)
+                            unsigned char stored = STATE_JOURNAL_MARKER | this->state;
+                            if (this->stateProperty->get() != stored) {
+                                this->stateProperty->set(stored);
+                            }
+
+                            this->writeWarmRecord();
+                        }
+
+                        /**
+                         * Update remaining shutdown buffer time (RAM only, called each loop)
+                         */
+                        void update(unsigned long bufferRemaining)
+                        {
+                            this->bufferRemaining = bufferRemaining;
+                            this->writeWarmRecord();
+                        }
+
+                        /**
+                         * Flag to indicate if journal comes from a warm reset (remaining buffer time is known)
+                         */
+                        bool isWarm()
+                        {
+                            return this->warm;
+                        }
+
+                        /**
+                         * Journaled output state
+                         */
+                        bool getOutputState()
+                        {
+                            return (this->state & OUTPUT_STATE) != 0;
+                        }
+
+                        /**
+                         * Journaled shutdown requested flag
+                         */
+                        bool isShutdownRequested()
+                        {
+                            return (this->state & SHUTDOWN_REQUESTED) != 0;
+                        }
+
+                        /**
+                         * Journaled remaining shutdown buffer time (in ms, only valid on warm reset)
+                         */
+                        unsigned long getBufferRemaining()
+                        {
+                            return this->bufferRemaining;
+                        }
+
+                    protected:
+                        /**
+                         * Calculate record checksum
+                         */
+                        static unsigned char checksum(StateJournalRecord * record)
+                        {
+                            unsigned char * data = (unsigned char *) record;
+                            unsigned char sum = 0x5A;
+                            for (unsigned char i = 0; i < sizeof(StateJournalRecord) - 1; i++) {
+                                sum = (sum << 1 | sum >> 7) ^ data[i];
+                            }
+
+                            return sum;
+                        }
+
+                        /**
+                         * Write current journal to warm record
+                         */
+                        void writeWarmRecord()
+                        {
+                            StateJournalRecord * record = &stateJournalRecord;
+                            record->magic = STATE_JOURNAL_MAGIC;
+                            record->state = this->state;
+                            record->bufferRemaining = this->bufferRemaining;
+                            record->checksum = StateJournal::checksum(record);
+                        }
+
+                        /**
+                         * Journaled state property (EEPROM)
+                         */
+                        StoredProperty<unsigned char> * stateProperty = NULL;
+
+                        /**
+                         * Journaled state (flags)
+                         */
+                        unsigned char state = 0;
+
+                        /**
+                         * Remaining shutdown buffer time (in ms)
+                         */
+                        unsigned long bufferRemaining = 0;
+
+                        /**
+                         * Flag to indicate if journal has been restored from a warm reset
+                         */
+                        bool warm = false;
+                    };
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_STATEJOURNAL_H
@@ -12,8 +12,19 @@
 #include <com/osteres/automation/actuator/timeswitch/PowerControl.h>
 #include <com/osteres/automation/arduino/memory/PinProperty.h>
 #include <com/osteres/automation/arduino/memory/StoredProperty.h>
-#include <com/osteres/automation/arduino/component/DataBuffer.h>
+#include <com/osteres/automation/actuator/timeswitch/component/ShutdownBuffer.h>
+#include <com/osteres/automation/actuator/timeswitch/component/Watchdog.h>
+#include <com/osteres/automation/actuator/timeswitch/component/OvercurrentProtection.h>
+#include <com/osteres/automation/actuator/timeswitch/component/CurrentSensorCalibration.h>
+#include <com/osteres/automation/actuator/timeswitch/component/ShutdownStatistics.h>
+#include <com/osteres/automation/actuator/timeswitch/component/LinkMonitor.h>
 #include <com/osteres/automation/actuator/timeswitch/action/TransmitState.h>
+#include <com/osteres/automation/actuator/timeswitch/action/Report.h>
+#include <com/osteres/automation/actuator/timeswitch/StateJournal.h>
+
+// Heap break (avr-libc malloc), to measure heap reserved by construct()
+extern char * __brkval;
+extern char * __malloc_heap_start;
 
 using com::osteres::automation::arduino::ArduinoApplication;
 using com::osteres::automation::sensor::Identity;
@@ -21,8 +32,15 @@ using com::osteres::automation::actuator::timeswitch::action::ActionManager;
 using com::osteres::automation::actuator::timeswitch::PowerControl;
 using com::osteres::automation::arduino::memory::PinProperty;
 using com::osteres::automation::arduino::memory::StoredProperty;
-using com::osteres::automation::arduino::component::DataBuffer;
+using com::osteres::automation::actuator::timeswitch::component::ShutdownBuffer;
+using com::osteres::automation::actuator::timeswitch::component::Watchdog;
+using com::osteres::automation::actuator::timeswitch::component::OvercurrentProtection;
+using com::osteres::automation::actuator::timeswitch::component::CurrentSensorCalibration;
+using com::osteres::automation::actuator::timeswitch::component::ShutdownStatistics;
+using com::osteres::automation::actuator::timeswitch::component::LinkMonitor;
 using com::osteres::automation::actuator::timeswitch::action::TransmitState;
+using com::osteres::automation::actuator::timeswitch::action::Report;
+using com::osteres::automation::actuator::timeswitch::StateJournal;
 
 namespace com
 {
@@ -88,6 +106,31 @@ namespace com
                                 delete this->actionTransmitState;
                                 this->actionTransmitState = NULL;
                             }
+                            // Remove state journal
+                            if (this->stateJournal != NULL) {
+                                delete this->stateJournal;
+                                this->stateJournal = NULL;
+                            }
+                            // Remove watchdog
+                            if (this->watchdog != NULL) {
+                                delete this->watchdog;
+                                this->watchdog = NULL;
+                            }
+                            // Remove overcurrent protection
+                            if (this->overcurrentProtection != NULL) {
+                                delete this->overcurrentProtection;
+                                this->overcurrentProtection = NULL;
+                            }
+                            // Remove overcurrent limit property
+                            if (this->overcurrentLimitProperty != NULL) {
+                                delete this->overcurrentLimitProperty;
+                                this->overcurrentLimitProperty = NULL;
+                            }
+                            // Remove link monitor
+                            if (this->linkMonitor != NULL) {
+                                delete this->linkMonitor;
+                                this->linkMonitor = NULL;
+                            }
                         }
 
                         /**
@@ -98,11 +141,46 @@ namespace com
                             // Parent
                             ArduinoApplication::setup();
 
-                            // Ensure that power command is off
-                            this->getPowerControl()->hardPowerOff();
+                            // Journal and send power state to master as soon as it changes
+                            this->getPowerControl()->addListener(this->getStateJournal());
+                            this->getPowerControl()->addListener(this->getActionTransmitState());
+
+                            // Resume journaled state if confirmed by current consumption, otherwise ensure that power command is off
+                            bool resumed = this->restoreState();
+
+                            // Overcurrent fast path
+                            this->getOvercurrentProtection()->setup();
 
                             // Transmission
                             this->transmitter->setActionManager(this->getActionManager());
+                            this->getLinkMonitor()->setup();
+
+                            // Boot to ready time
+                            this->bootDuration = millis();
+                            Serial.print(F("Ready in "));
+                            Serial.print(this->bootDuration);
+                            Serial.println(resumed ? F("ms, state resumed") : F("ms"));
+                            Serial.print(F("Heap reserved by construct: "));
+                            Serial.println(this->constructHeap);
+                            this->getActionTransmitState()->report(
+                                Report::BOOT,
+                                this->bootDuration,
+                                (resumed ? 1 : 0) | (long) this->constructHeap << 8
+                            );
+
+                            // Reset cause, with stage which hung if reset by watchdog
+                            Watchdog * watchdog = this->getWatchdog();
+                            Serial.print(F("Reset cause: "));
+                            Serial.print(watchdog->getResetCause(), HEX);
+                            Serial.print(F(", last stage: "));
+                            Serial.println(watchdog->getLastStage(), HEX);
+                            this->getActionTransmitState()->report(Report::RESET, watchdog->getResetCause(), watchdog->getLastStage());
+
+                            // Learned shutdown durations (sent from process, one packet by loop)
+                            this->shutdownReportPending = this->getPowerControl()->getShutdownStatistics()->getCount() > 0;
+
+                            // Boot done, supervise process stages
+                            watchdog->setup();
 
 
                             // TEMP
@@ -115,11 +193,19 @@ namespace com
                         virtual void process()
                         {
                             // Request an identifier if needed. Note: Not mandatory anymore
+                            Watchdog * watchdog = this->getWatchdog();
+
                             if (this->isNeedIdentifier()) {
                                 this->requestForAnIdentifier();
 
-                                // Send and listen
+                                // Send and listen (radio listening since previous exchange: carrier sampled first)
+                                watchdog->enter(Watchdog::STAGE_RADIO);
+                                this->getLinkMonitor()->sampleCarrier();
                                 this->transmitter->srs(3000); // 3s
+                                watchdog->checkIn(Watchdog::STAGE_RADIO);
+
+                                // Others stages not processed while waiting for identifier
+                                watchdog->checkIn(Watchdog::STAGE_MEASURE | Watchdog::STAGE_CONTROL | Watchdog::STAGE_REPORT);
 
                             } // Process
                             else {
@@ -129,6 +215,9 @@ namespace com
                                 //
                                 // Update real state of device
                                 //
+                                watchdog->enter(Watchdog::STAGE_MEASURE);
+                                this->getOvercurrentProtection()->check();
+                                this->processFault();
                                 // If shutdown has been requested, keep in touch to terminate process
                                 if (powerControl->isShutdownRequested()) {
                                     powerControl->securePowerOff();
@@ -142,14 +231,23 @@ namespace com
                                         powerControl->hardPowerOff();
                                     }
                                 }
+                                watchdog->checkIn(Watchdog::STAGE_MEASURE);
 
-                                // Listen and send
+                                // Listen and send (radio listening since previous exchange: carrier sampled first)
+                                watchdog->enter(Watchdog::STAGE_RADIO);
+                                this->getLinkMonitor()->sampleCarrier();
                                 this->transmitter->rsr();
+                                watchdog->checkIn(Watchdog::STAGE_RADIO);
 
                                 // Forced power on
+                                watchdog->enter(Watchdog::STAGE_CONTROL);
                                 if (powerControl->isLockPowerOn()) {
-                                    // If power off, so power on
-                                    if (!powerControl->getOutputState() || powerControl->isShutdownRequested()) {
+                                    // If power off, so power on (except while fault latched: output stays cut until cleared)
+                                    if (powerControl->isFaultLatched()) {
+                                        // Skipped: refused by power control (logged once), shutdown buffer untouched
+                                        powerControl->powerOn();
+                                    }
+                                    else if (!powerControl->getOutputState() || powerControl->isShutdownRequested()) {
                                         powerControl->powerOn();
 
                                         // Reset shutdown buffer
@@ -168,9 +266,34 @@ namespace com
                                         powerControl->securePowerOff();
                                     }
                                 }
+                                watchdog->checkIn(Watchdog::STAGE_CONTROL);
 
-                                // Send power state
-                                this->requestForSendData();
+                                // Send power state (periodic), except if already sent on transition by listener
+                                watchdog->enter(Watchdog::STAGE_REPORT);
+                                if (!this->getActionTransmitState()->isStateQueued()) {
+                                    this->requestForSendData();
+                                }
+                                this->getActionTransmitState()->setStateQueued(false);
+
+                                // Journal remaining time before shutdown
+                                this->getStateJournal()->update(this->getShutdownBuffer()->getRemaining());
+
+                                // New shutdown duration learned: send statistics again from first part
+                                ShutdownStatistics * statistics = powerControl->getShutdownStatistics();
+                                if (statistics->getRecordCount() != this->reportedShutdownCount) {
+                                    this->reportedShutdownCount = statistics->getRecordCount();
+                                    this->shutdownReportPending = true;
+                                    this->shutdownReportPart = 0;
+                                }
+                                if (this->shutdownReportPending) {
+                                    this->reportShutdownStatistics();
+                                }
+
+                                // Link quality changed, periodic or channel hop request
+                                if (this->getLinkMonitor()->isReportPending()) {
+                                    this->reportLink();
+                                }
+                                watchdog->checkIn(Watchdog::STAGE_REPORT);
 
                                 // Otherwise, power control done by ActionManager
                                 Serial.println(this->getPowerControl()->getOutputState() ? "on" : "off");
@@ -208,7 +331,7 @@ namespace com
                         /**
                          * Get shutdown buffer: time before send shutdown command
                          */
-                        DataBuffer * getShutdownBuffer()
+                        ShutdownBuffer * getShutdownBuffer()
                         {
                             return this->shutdownBuffer;
                         }
@@ -231,8 +354,156 @@ namespace com
                             return this->actionTransmitState;
                         }
 
+                        /**
+                         * Send next part of shutdown statistics to master: statistics, then histogram packs.
+                         * One packet by call, to avoid queuing all parts at once
+                         */
+                        void reportShutdownStatistics()
+                        {
+                            ShutdownStatistics * statistics = this->getPowerControl()->getShutdownStatistics();
+                            TransmitState * action = this->getActionTransmitState();
+
+                            if (this->shutdownReportPart == 0) {
+                                action->report(
+                                    Report::SHUTDOWN_STATISTICS,
+                                    statistics->getLastDuration(),
+                                    statistics->getPercentile(50) / 1000 | (statistics->getPercentile(99) / 1000) << 16
+                                );
+                            } else {
+                                unsigned char pack = this->shutdownReportPart - 1;
+                                action->report(Report::SHUTDOWN_HISTOGRAM, pack * 4, statistics->getPack(pack));
+                            }
+
+                            // All parts sent
+                            if (++this->shutdownReportPart > SHUTDOWN_HISTOGRAM_PACKS) {
+                                this->shutdownReportPart = 0;
+                                this->shutdownReportPending = false;
+                            }
+                        }
+
+                        /**
+                         * Send radio link quality to master
+                         */
+                        void reportLink()
+                        {
+                            LinkMonitor * linkMonitor = this->getLinkMonitor();
+                            RF24 * radio = linkMonitor->getRadio();
+
+                            this->getActionTransmitState()->report(
+                                Report::LINK,
+                                (long) linkMonitor->getAckRate() |
+                                    (long) linkMonitor->getAverageRetries() << 8 |
+                                    (long) linkMonitor->getCarrierRate() << 16 |
+                                    (long) linkMonitor->getLevel() << 24,
+                                (long) radio->getChannel() |
+                                    (long) radio->getDataRate() << 8 |
+                                    (long) (linkMonitor->isHopRequested() ? 1 : 0) << 16 |
+                                    (long) (linkMonitor->isStalled() ? 1 : 0) << 17
+                            );
+                        }
+
+                        /**
+                         * Get radio link monitor
+                         */
+                        LinkMonitor * getLinkMonitor()
+                        {
+                            return this->linkMonitor;
+                        }
+
+                        /**
+                         * Get state journal
+                         */
+                        StateJournal * getStateJournal()
+                        {
+                            return this->stateJournal;
+                        }
+
+                        /**
+                         * Get overcurrent protection (fast path)
+                         */
+                        OvercurrentProtection * getOvercurrentProtection()
+                        {
+                            return this->overcurrentProtection;
+                        }
+
+                        /**
+                         * Get overcurrent limit property (in mA)
+                         */
+                        StoredProperty<unsigned int> * getOvercurrentLimitProperty()
+                        {
+                            return this->overcurrentLimitProperty;
+                        }
+
+                        /**
+                         * Get watchdog
+                         */
+                        Watchdog * getWatchdog()
+                        {
+                            return this->watchdog;
+                        }
+
+                        /**
+                         * Get boot to ready time (in ms)
+                         */
+                        unsigned long getBootDuration()
+                        {
+                            return this->bootDuration;
+                        }
+
                     protected:
 
+                        /**
+                         * Update state and report to master if a fault has been tripped
+                         */
+                        void processFault()
+                        {
+                            PowerControl * powerControl = this->getPowerControl();
+
+                            if (powerControl->handleFault()) {
+                                this->getActionTransmitState()->report(
+                                    Report::FAULT,
+                                    powerControl->getFaultSource(),
+                                    (long) powerControl->readCurrent()
+                                );
+                            }
+                        }
+
+                        /**
+                         * Restore journaled state. Power on is resumed only if device really consume current
+                         * and if no overcurrent has been measured by this check.
+                         * Return true if power on has been resumed
+                         */
+                        bool restoreState()
+                        {
+                            PowerControl * powerControl = this->getPowerControl();
+                            StateJournal * journal = this->getStateJournal();
+
+                            if (
+                                journal->getOutputState() &&
+                                powerControl->isReallyPowerOn() &&
+                                !powerControl->isFaultLatched()
+                            ) {
+                                powerControl->resumePowerOn(journal->isShutdownRequested());
+
+                                // Remaining time only known after warm reset, otherwise restart full delay
+                                if (journal->isWarm()) {
+                                    this->getShutdownBuffer()->resume(journal->getBufferRemaining());
+                                } else {
+                                    this->getShutdownBuffer()->reset();
+                                }
+
+                                return true;
+                            }
+
+                            // Ensure that power command is off
+                            powerControl->hardPowerOff();
+
+                            // Journal may be outdated (state unchanged, so no notification)
+                            journal->onStateChange(powerControl);
+
+                            return false;
+                        }
+
                         /**
                          * Common part constructor
                          */
@@ -243,6 +514,8 @@ namespace com
                             unsigned int switchLockPowerOnPin,
                             unsigned int switchAutoModePin
                         ) {
+                            unsigned int heapStart = TimeSwitchApplication::getHeapUsed();
+
                             // Create power control
                             this->powerControl = new PowerControl(
                                 powerOffCommandPin,
@@ -258,11 +531,60 @@ namespace com
                             if (this->shutdownDelayProperty->get() == 0) {
                                 this->shutdownDelayProperty->set(30000); // 30s
                             }
-                            this->shutdownBuffer = new DataBuffer(this->shutdownDelayProperty->get());
+                            this->shutdownBuffer = new ShutdownBuffer(this->shutdownDelayProperty->get());
+
+                            // State journal (configured after existing properties to keep their EEPROM location)
+                            StoredProperty<unsigned char> * journalStateProperty = new StoredProperty<unsigned char>();
+                            StoredPropertyManager::configure(journalStateProperty);
+                            this->stateJournal = new StateJournal(journalStateProperty);
+
+                            // Overcurrent limit (slow path) and comparator (fast path)
+                            this->overcurrentLimitProperty = new StoredProperty<unsigned int>();
+                            StoredPropertyManager::configure(this->overcurrentLimitProperty);
+                            // Erased EEPROM only: 0 is a valid value (slow path disabled)
+                            if (this->overcurrentLimitProperty->get() == 0xFFFF) {
+                                this->overcurrentLimitProperty->set(3000); // 3A
+                            }
+                            this->powerControl->setOvercurrentLimit(this->overcurrentLimitProperty->get());
+                            this->overcurrentProtection = new OvercurrentProtection(this->powerControl);
+
+                            // Current sensor zero offset calibration
+                            StoredProperty<unsigned int> * calibrationOffsetProperty = new StoredProperty<unsigned int>();
+                            StoredPropertyManager::configure(calibrationOffsetProperty);
+                            this->powerControl->setCalibration(new CurrentSensorCalibration(calibrationOffsetProperty));
+
+                            // Shutdown duration histogram
+                            StoredProperty<unsigned long> * histogramProperties[SHUTDOWN_HISTOGRAM_PACKS];
+                            for (unsigned char i = 0; i < SHUTDOWN_HISTOGRAM_PACKS; i++) {
+                                histogramProperties[i] = new StoredProperty<unsigned long>();
+                                StoredPropertyManager::configure(histogramProperties[i]);
+                            }
+                            this->powerControl->setShutdownStatistics(new ShutdownStatistics(histogramProperties));
+
+                            // Watchdog: fed only when all stages of process are alive
+                            this->watchdog = new Watchdog(
+                                Watchdog::STAGE_MEASURE | Watchdog::STAGE_RADIO | Watchdog::STAGE_CONTROL | Watchdog::STAGE_REPORT,
+                                WDTO_8S
+                            );
 
                             // Create action manager (process when receive transmission)
                             ActionManager *actionManager = new ActionManager(this->powerControl, this->shutdownBuffer);
+                            actionManager->setOvercurrentLimitProperty(this->overcurrentLimitProperty);
+
+                            // Radio link quality (adaptive retries / PA level, channel and data rate agreed with master)
+                            this->linkMonitor = new LinkMonitor(this->transmitter->getRadio());
+                            actionManager->setLinkMonitor(this->linkMonitor);
                             this->setActionManager(actionManager);
+
+                            this->constructHeap = TimeSwitchApplication::getHeapUsed() - heapStart;
+                        }
+
+                        /**
+                         * Get heap used (in bytes, malloc headers included)
+                         */
+                        static unsigned int getHeapUsed()
+                        {
+                            return __brkval != NULL ? __brkval - __malloc_heap_start : 0;
                         }
 
                         /**
@@ -273,7 +595,7 @@ namespace com
                         /**
                          * Shutdown buffer: time before send shutdown command
                          */
-                        DataBuffer * shutdownBuffer = NULL;
+                        ShutdownBuffer * shutdownBuffer = NULL;
 
                         /**
                          * Shutdown delay property
@@ -284,6 +606,56 @@ namespace com
                          * Action to transmit switch state
                          */
                         TransmitState * actionTransmitState = NULL;
+
+                        /**
+                         * Journal of power state (resume after reset)
+                         */
+                        StateJournal * stateJournal = NULL;
+
+                        /**
+                         * Overcurrent protection (analog comparator)
+                         */
+                        OvercurrentProtection * overcurrentProtection = NULL;
+
+                        /**
+                         * Overcurrent limit property (in mA)
+                         */
+                        StoredProperty<unsigned int> * overcurrentLimitProperty = NULL;
+
+                        /**
+                         * Radio link monitor
+                         */
+                        LinkMonitor * linkMonitor = NULL;
+
+                        /**
+                         * Watchdog (per stage liveness)
+                         */
+                        Watchdog * watchdog = NULL;
+
+                        /**
+                         * Boot to ready time (in ms)
+                         */
+                        unsigned long bootDuration = 0;
+
+                        /**
+                         * Heap reserved by construct() (in bytes), measured
+                         */
+                        unsigned int constructHeap = 0;
+
+                        /**
+                         * Number of shutdowns recorded since boot already reported to master
+                         */
+                        unsigned int reportedShutdownCount = 0;
+
+                        /**
+                         * Flag to indicate if shutdown statistics remain to be sent
+                         */
+                        bool shutdownReportPending = false;
+
+                        /**
+                         * Next part of shutdown statistics to send (0: statistics, then histogram packs)
+                         */
+                        unsigned char shutdownReportPart = 0;
                     };
                 }
             }
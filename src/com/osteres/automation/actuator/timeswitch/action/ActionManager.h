@@ -6,18 +6,21 @@
 #define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_ACTION_ACTIONMANAGER_H
 
 #include <Arduino.h>
-#include <StandardCplusplus.h>
-#include <string>
 #include <com/osteres/automation/transmission/packet/Command.h>
 #include <com/osteres/automation/transmission/packet/Packet.h>
+#include <com/osteres/automation/arduino/memory/StoredProperty.h>
 #include <com/osteres/automation/actuator/timeswitch/PowerControl.h>
-#include <com/osteres/automation/arduino/component/DataBuffer.h>
+#include <com/osteres/automation/actuator/timeswitch/component/ShutdownBuffer.h>
+#include <com/osteres/automation/actuator/timeswitch/component/LinkMonitor.h>
+#include <com/osteres/automation/actuator/timeswitch/action/Config.h>
 
 using com::osteres::automation::transmission::packet::Command;
 using com::osteres::automation::transmission::packet::Packet;
+using com::osteres::automation::arduino::memory::StoredProperty;
 using com::osteres::automation::actuator::timeswitch::PowerControl;
-using com::osteres::automation::arduino::component::DataBuffer;
-using std::string;
+using com::osteres::automation::actuator::timeswitch::component::ShutdownBuffer;
+using com::osteres::automation::actuator::timeswitch::component::LinkMonitor;
+using com::osteres::automation::actuator::timeswitch::action::Config;
 
 namespace com
 {
@@ -37,7 +40,7 @@ namespace com
                             /**
                              * Constructor
                              */
-                            ActionManager(PowerControl * powerControl, DataBuffer * shutdownBuffer) : ArduinoActionManager()
+                            ActionManager(PowerControl * powerControl, ShutdownBuffer * shutdownBuffer) : ArduinoActionManager()
                             {
                                 this->powerControl = powerControl;
                                 this->shutdownBuffer = shutdownBuffer;
@@ -59,6 +62,11 @@ namespace com
                                     // Read enable value
                                     bool enable = packet->getDataUChar1() == 1;
 
+                                    // Power off command acknowledge latched fault
+                                    if (!enable && powerControl->isFaultLatched()) {
+                                        powerControl->clearFault();
+                                    }
+
                                     // If power on command and output currently power off
                                     if (enable && !powerControl->getOutputState()) {
                                         // Power on
@@ -86,7 +94,26 @@ namespace com
                                 }
                                 // CONFIG command
                                 else if (packet->getCommand() == Command::CONFIG) {
-                                    // TODO
+                                    LinkMonitor * linkMonitor = this->getLinkMonitor();
+                                    StoredProperty<unsigned int> * overcurrentLimitProperty = this->getOvercurrentLimitProperty();
+
+                                    // Overcurrent limit (0xFFFF reserved for erased EEPROM)
+                                    if (
+                                        overcurrentLimitProperty != NULL &&
+                                        packet->getDataUChar1() == Config::OVERCURRENT_LIMIT &&
+                                        packet->getDataLong1() >= 0 &&
+                                        packet->getDataLong1() < 0xFFFF
+                                    ) {
+                                        overcurrentLimitProperty->set(packet->getDataLong1());
+                                        powerControl->setOvercurrentLimit(packet->getDataLong1());
+                                    }
+                                    // Radio configuration agreed with master
+                                    else if (linkMonitor != NULL && packet->getDataUChar1() == Config::CHANNEL) {
+                                        linkMonitor->setChannel(packet->getDataLong1());
+                                    }
+                                    else if (linkMonitor != NULL && packet->getDataUChar1() == Config::DATA_RATE) {
+                                        linkMonitor->setDataRate(packet->getDataLong1());
+                                    }
                                 }
                             }
 
@@ -101,11 +128,43 @@ namespace com
                             /**
                              * Get shutdown buffer: time before send shutdown command
                              */
-                            DataBuffer * getShutdownBuffer()
+                            ShutdownBuffer * getShutdownBuffer()
                             {
                                 return this->shutdownBuffer;
                             }
 
+                            /**
+                             * Get overcurrent limit property (in mA)
+                             */
+                            StoredProperty<unsigned int> * getOvercurrentLimitProperty()
+                            {
+                                return this->overcurrentLimitProperty;
+                            }
+
+                            /**
+                             * Set overcurrent limit property (in mA, configured by master)
+                             */
+                            void setOvercurrentLimitProperty(StoredProperty<unsigned int> * overcurrentLimitProperty)
+                            {
+                                this->overcurrentLimitProperty = overcurrentLimitProperty;
+                            }
+
+                            /**
+                             * Get radio link monitor
+                             */
+                            LinkMonitor * getLinkMonitor()
+                            {
+                                return this->linkMonitor;
+                            }
+
+                            /**
+                             * Set radio link monitor (configured by master)
+                             */
+                            void setLinkMonitor(LinkMonitor * linkMonitor)
+                            {
+                                this->linkMonitor = linkMonitor;
+                            }
+
                         protected:
 
                             /**
@@ -116,7 +175,17 @@ namespace com
                             /**
                              * Shutdown buffer: time before send shutdown command
                              */
-                            DataBuffer * shutdownBuffer = NULL;
+                            ShutdownBuffer * shutdownBuffer = NULL;
+
+                            /**
+                             * Overcurrent limit property (in mA)
+                             */
+                            StoredProperty<unsigned int> * overcurrentLimitProperty = NULL;
+
+                            /**
+                             * Radio link monitor
+                             */
+                            LinkMonitor * linkMonitor = NULL;
 
                         };
                     }
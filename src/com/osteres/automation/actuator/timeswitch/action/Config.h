@@ -0,0 +1,44 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_ACTION_CONFIG_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_ACTION_CONFIG_H
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    namespace action
+                    {
+                        /**
+                         * Configuration keys received from master in CONFIG packet (dataUChar1), value in dataLong1
+                         */
+                        class Config
+                        {
+                        public:
+                            /**
+                             * Radio channel (0-125), agreed after channel hop request
+                             */
+                            static unsigned char const CHANNEL = 1;
+
+                            /**
+                             * Radio data rate (rf24_datarate_e)
+                             */
+                            static unsigned char const DATA_RATE = 2;
+
+                            /**
+                             * Overcurrent limit of slow path (mA, 0 to disable), persisted
+                             */
+                            static unsigned char const OVERCURRENT_LIMIT = 3;
+                        };
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_ACTION_CONFIG_H
@@ -0,0 +1,83 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_ACTION_REPORT_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_ACTION_REPORT_H
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    namespace action
+                    {
+                        /**
+                         * Report codes sent to master in DATA packet (dataUChar2)
+                         * dataUChar1 always contains output state, so master unaware of reports still read state
+                         */
+                        class Report
+                        {
+                        public:
+                            /**
+                             * Output state. dataLong1: status flags (STATUS_xxx)
+                             */
+                            static unsigned char const STATE = 0;
+
+                            /**
+                             * Boot done. dataLong1: boot to ready time (ms),
+                             * dataLong2: 1 if state resumed, 0 otherwise | heap reserved by construct() (bytes) << 8
+                             */
+                            static unsigned char const BOOT = 1;
+
+                            /**
+                             * Reset cause. dataLong1: MCUSR flags (0xFF if unknown), dataLong2: stage active at watchdog reset (0 otherwise)
+                             */
+                            static unsigned char const RESET = 2;
+
+                            /**
+                             * Overcurrent fault latched. dataLong1: fault source (PowerControl::FAULT_xxx), dataLong2: last measured current (mA)
+                             */
+                            static unsigned char const FAULT = 3;
+
+                            /**
+                             * Shutdown statistics. dataLong1: last shutdown duration (ms), dataLong2: p50 (s) | p99 (s) << 16
+                             */
+                            static unsigned char const SHUTDOWN_STATISTICS = 4;
+
+                            /**
+                             * Shutdown duration histogram part. dataLong1: first bin index, dataLong2: 4 bins packed (first in low byte)
+                             */
+                            static unsigned char const SHUTDOWN_HISTOGRAM = 5;
+
+                            /**
+                             * Radio link quality.
+                             * dataLong1: ack rate (%) | average retries (x10) << 8 | carrier detected rate (%) << 16 | profile level << 24
+                             * dataLong2: channel | data rate << 8 | channel hop requested << 16 | monitor stalled (no send recorded) << 17
+                             */
+                            static unsigned char const LINK = 6;
+
+                            /**
+                             * Status flag: shutdown requested
+                             */
+                            static unsigned char const STATUS_SHUTDOWN_REQUESTED = 0x01;
+
+                            /**
+                             * Status flag: fault latched, output cut until fault cleared by master
+                             */
+                            static unsigned char const STATUS_FAULT = 0x02;
+
+                            /**
+                             * Status flag: shutdown lasts longer than learned p99
+                             */
+                            static unsigned char const STATUS_SHUTDOWN_ANOMALY = 0x04;
+                        };
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_ACTION_REPORT_H
@@ -6,7 +6,6 @@
 #define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_ACTION_TRANSMITSTATE_H
 
 #include <Arduino.h>
-#include <StandardCplusplus.h>
 #include <com/osteres/automation/action/Action.h>
 #include <com/osteres/automation/transmission/Transmitter.h>
 #include <com/osteres/automation/transmission/packet/Packet.h>
@@ -14,6 +13,8 @@
 #include <com/osteres/automation/arduino/memory/StoredProperty.h>
 #include <com/osteres/automation/memory/Property.h>
 #include <com/osteres/automation/actuator/timeswitch/PowerControl.h>
+#include <com/osteres/automation/actuator/timeswitch/PowerControlListener.h>
+#include <com/osteres/automation/actuator/timeswitch/action/Report.h>
 
 using com::osteres::automation::action::Action;
 using com::osteres::automation::transmission::Transmitter;
@@ -22,6 +23,8 @@ using com::osteres::automation::transmission::packet::Command;
 using com::osteres::automation::memory::Property;
 using com::osteres::automation::arduino::memory::StoredProperty;
 using com::osteres::automation::actuator::timeswitch::PowerControl;
+using com::osteres::automation::actuator::timeswitch::PowerControlListener;
+using com::osteres::automation::actuator::timeswitch::action::Report;
 
 namespace com
 {
@@ -35,7 +38,7 @@ namespace com
                 {
                     namespace action
                     {
-                        class TransmitState : public Action
+                        class TransmitState : public Action, public PowerControlListener
                         {
                         public:
                             /**
@@ -60,6 +63,25 @@ namespace com
                              * Execute action
                              */
                             bool execute()
+                            {
+                                long status = 0;
+                                if (this->powerControl->isShutdownRequested()) {
+                                    status |= Report::STATUS_SHUTDOWN_REQUESTED;
+                                }
+                                if (this->powerControl->isFaultLatched()) {
+                                    status |= Report::STATUS_FAULT;
+                                }
+                                if (this->powerControl->isShutdownAnomaly()) {
+                                    status |= Report::STATUS_SHUTDOWN_ANOMALY;
+                                }
+
+                                return this->report(Report::STATE, status, 0);
+                            }
+
+                            /**
+                             * Send a report to master, output state always included
+                             */
+                            bool report(unsigned char code, long value, long extra)
                             {
                                 // parent
                                 Action::execute();
@@ -70,6 +92,9 @@ namespace com
                                 packet->setSourceIdentifier(this->propertyIdentifier->get());
                                 packet->setCommand(Command::DATA);
                                 packet->setDataUChar1(this->powerControl->getOutputState() ? 1 : 0);
+                                packet->setDataUChar2(code);
+                                packet->setDataLong1(value);
+                                packet->setDataLong2(extra);
                                 packet->setTarget(this->to);
 
                                 // Transmit packet
@@ -79,6 +104,31 @@ namespace com
                                 return this->isSuccess();
                             }
 
+                            /**
+                             * Power control state changed: queue state packet immediately
+                             */
+                            virtual void onStateChange(PowerControl * powerControl)
+                            {
+                                this->execute();
+                                this->stateQueued = true;
+                            }
+
+                            /**
+                             * Flag to indicate if a state packet has been queued on transition
+                             */
+                            bool isStateQueued()
+                            {
+                                return this->stateQueued;
+                            }
+
+                            /**
+                             * Set flag to indicate if a state packet has been queued on transition
+                             */
+                            void setStateQueued(bool flag)
+                            {
+                                this->stateQueued = flag;
+                            }
+
                         protected:
                             /**
                              * Sensor type identifier property
@@ -104,6 +154,11 @@ namespace com
                              * Power control component
                              */
                             PowerControl * powerControl = NULL;
+
+                            /**
+                             * Flag to indicate if a state packet has been queued on transition
+                             */
+                            bool stateQueued = false;
                         };
                     }
                 }
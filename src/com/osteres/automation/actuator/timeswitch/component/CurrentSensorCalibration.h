@@ -0,0 +1,139 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_CURRENTSENSORCALIBRATION_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_CURRENTSENSORCALIBRATION_H
+
+#define CALIBRATION_NOMINAL_OFFSET 8184 // Vcc/2 in 1/16 ADC count (511.5 * 16)
+#define CALIBRATION_MAX_DEVIATION 640 // Max offset deviation learned (1/16 ADC count, 40 counts ~ 1A)
+#define CALIBRATION_MIN_SAMPLES 64 // Samples learned before persisting offset
+#define CALIBRATION_PERSIST_DRIFT 16 // Drift before persisting offset again (1/16 ADC count)
+
+#include <Arduino.h>
+#include <com/osteres/automation/arduino/memory/StoredProperty.h>
+
+using com::osteres::automation::arduino::memory::StoredProperty;
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    namespace component
+                    {
+                        /**
+                         * Current sensor zero offset, learned while output is known to be off
+                         * Offset kept in 1/16 ADC count (fixed point), persisted to EEPROM on drift only
+                         */
+                        class CurrentSensorCalibration
+                        {
+                        public:
+                            /**
+                             * Constructor
+                             * Calibration takes ownership of offset property (configured by caller)
+                             */
+                            CurrentSensorCalibration(StoredProperty<unsigned int> * offsetProperty)
+                            {
+                                this->offsetProperty = offsetProperty;
+
+                                // Erased or invalid EEPROM: nominal offset (Vcc/2)
+                                unsigned int stored = this->offsetProperty->get();
+                                if (CurrentSensorCalibration::isPlausible(stored)) {
+                                    this->offset = stored;
+                                    this->persistedOffset = stored;
+                                } else {
+                                    this->offset = CALIBRATION_NOMINAL_OFFSET;
+                                    this->persistedOffset = 0;
+                                }
+                            }
+
+                            /**
+                             * Destructor
+                             */
+                            virtual ~CurrentSensorCalibration()
+                            {
+                                // Remove offset property
+                                if (this->offsetProperty != NULL) {
+                                    delete this->offsetProperty;
+                                    this->offsetProperty = NULL;
+                                }
+                            }
+
+                            /**
+                             * Learn offset from an ADC read done while output is off (no current)
+                             */
+                            void learn(unsigned int vRead)
+                            {
+                                unsigned int sample = vRead << 4;
+
+                                // Ignore sample too far from nominal (device not really off, sensor fault)
+                                if (!CurrentSensorCalibration::isPlausible(sample)) {
+                                    return;
+                                }
+
+                                // Exponential moving average (1/8)
+                                this->offset = (unsigned int) ((long) this->offset + ((long) sample - (long) this->offset) / 8);
+
+                                if (this->samples < CALIBRATION_MIN_SAMPLES) {
+                                    this->samples++;
+                                    return;
+                                }
+
+                                // Persist on drift only (limit EEPROM wear)
+                                unsigned int drift = this->offset > this->persistedOffset ?
+                                    this->offset - this->persistedOffset :
+                                    this->persistedOffset - this->offset;
+                                if (drift >= CALIBRATION_PERSIST_DRIFT) {
+                                    this->offsetProperty->set(this->offset);
+                                    this->persistedOffset = this->offset;
+                                }
+                            }
+
+                            /**
+                             * Get zero offset (in ADC count)
+                             */
+                            float getOffset()
+                            {
+                                return this->offset / 16.0;
+                            }
+
+                        protected:
+                            /**
+                             * Flag to indicate if offset (1/16 ADC count) is plausible for a zero current
+                             */
+                            static bool isPlausible(unsigned int offset)
+                            {
+                                return offset >= CALIBRATION_NOMINAL_OFFSET - CALIBRATION_MAX_DEVIATION &&
+                                    offset <= CALIBRATION_NOMINAL_OFFSET + CALIBRATION_MAX_DEVIATION;
+                            }
+
+                            /**
+                             * Offset property (EEPROM)
+                             */
+                            StoredProperty<unsigned int> * offsetProperty = NULL;
+
+                            /**
+                             * Current offset (1/16 ADC count)
+                             */
+                            unsigned int offset = CALIBRATION_NOMINAL_OFFSET;
+
+                            /**
+                             * Last persisted offset (1/16 ADC count)
+                             */
+                            unsigned int persistedOffset = 0;
+
+                            /**
+                             * Samples learned since boot
+                             */
+                            unsigned char samples = 0;
+                        };
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_CURRENTSENSORCALIBRATION_H
@@ -0,0 +1,370 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_LINKMONITOR_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_LINKMONITOR_H
+
+#define LINK_WINDOW 32 // Packets sent by statistics window
+#define LINK_LEVELS 4 // Number of link profiles (0: excellent, LINK_LEVELS - 1: poor)
+#define LINK_GOOD_ACK_RATE 98 // Ack rate (%) to step to a faster / lower power profile
+#define LINK_BAD_ACK_RATE 90 // Ack rate (%) to step to a more robust profile
+#define LINK_HOP_ACK_RATE 50 // Ack rate (%) on most robust profile to request a channel hop
+#define LINK_FALLBACK_WINDOWS 3 // Windows without any ack before returning to default channel and data rate
+#define LINK_REPORT_WINDOWS 10 // Windows between periodic link reports
+#define LINK_STALL_LOOPS 600 // Loops without any window closed before reporting monitor as stalled (no send recorded)
+
+#include <Arduino.h>
+#include <RF24/RF24.h>
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    namespace component
+                    {
+                        /**
+                         * Radio link quality monitor
+                         * - Statistics by window: ack rate and retries (recorded for each packet sent),
+                         *   carrier detected (RPD, sampled while listening)
+                         * - Retry count and PA level adapted locally to link quality
+                         * - Data rate and channel changed only when agreed with master (CONFIG command),
+                         *   with fallback to default ones if link is lost after change
+                         */
+                        class LinkMonitor
+                        {
+                        public:
+                            /**
+                             * Constructor
+                             */
+                            LinkMonitor(RF24 * radio)
+                            {
+                                this->radio = radio;
+                            }
+
+                            /**
+                             * Setup: keep default channel and data rate (rendezvous), apply most robust profile.
+                             * Faster / lower power profiles are used only after good windows
+                             */
+                            void setup()
+                            {
+                                this->defaultChannel = this->radio->getChannel();
+                                this->defaultDataRate = this->radio->getDataRate();
+                                this->applyLevel();
+                            }
+
+                            /**
+                             * Record result of a packet sent (write result, retries of this packet)
+                             */
+                            void recordSend(bool acked, unsigned char retries)
+                            {
+                                if (acked) {
+                                    this->windowAcked++;
+                                }
+                                this->windowRetries += retries;
+
+                                if (++this->windowSamples >= LINK_WINDOW) {
+                                    this->closeWindow();
+                                }
+                            }
+
+                            /**
+                             * Sample carrier on channel, once by loop. Radio must be listening for at least 170us (RPD valid)
+                             * Also check that sends are recorded: monitor reported as stalled if no window closes
+                             */
+                            void sampleCarrier()
+                            {
+                                if (this->radio->testRPD()) {
+                                    this->windowCarrier++;
+                                }
+                                this->windowCarrierSamples++;
+
+                                // Requester does not record sends (profile never adapted): report once
+                                if (!this->stalled && ++this->stallLoops >= LINK_STALL_LOOPS) {
+                                    this->stalled = true;
+                                    this->reportPending = true;
+                                }
+                            }
+
+                            /**
+                             * Flag to indicate if no window has closed for LINK_STALL_LOOPS loops (sends not recorded)
+                             */
+                            bool isStalled()
+                            {
+                                return this->stalled;
+                            }
+
+                            /**
+                             * Apply channel agreed with master
+                             */
+                            void setChannel(unsigned char channel)
+                            {
+                                this->radio->setChannel(channel);
+                                this->hopRequested = false;
+                                this->lostWindows = 0;
+                            }
+
+                            /**
+                             * Apply data rate agreed with master (rf24_datarate_e)
+                             */
+                            void setDataRate(unsigned char dataRate)
+                            {
+                                this->radio->setDataRate((rf24_datarate_e) dataRate);
+                                this->lostWindows = 0;
+                            }
+
+                            /**
+                             * Flag to indicate if a link report is pending (level changed, periodic, hop request)
+                             * Pending flag is cleared
+                             */
+                            bool isReportPending()
+                            {
+                                bool pending = this->reportPending;
+                                this->reportPending = false;
+
+                                return pending;
+                            }
+
+                            /**
+                             * Flag to indicate if a channel hop is requested to master
+                             */
+                            bool isHopRequested()
+                            {
+                                return this->hopRequested;
+                            }
+
+                            /**
+                             * Flag to indicate if channel hop can be requested
+                             */
+                            bool isHoppingEnabled()
+                            {
+                                return this->hoppingEnabled;
+                            }
+
+                            /**
+                             * Set flag to indicate if channel hop can be requested (master must support it)
+                             */
+                            void setHoppingEnabled(bool enabled)
+                            {
+                                this->hoppingEnabled = enabled;
+                            }
+
+                            /**
+                             * Get ack rate of last window (%)
+                             */
+                            unsigned char getAckRate()
+                            {
+                                return this->ackRate;
+                            }
+
+                            /**
+                             * Get average retries by send of last window (x10)
+                             */
+                            unsigned char getAverageRetries()
+                            {
+                                return this->averageRetries;
+                            }
+
+                            /**
+                             * Get carrier detected rate of last window (%)
+                             */
+                            unsigned char getCarrierRate()
+                            {
+                                return this->carrierRate;
+                            }
+
+                            /**
+                             * Get current link profile level (0: excellent)
+                             */
+                            unsigned char getLevel()
+                            {
+                                return this->level;
+                            }
+
+                            /**
+                             * Get radio
+                             */
+                            RF24 * getRadio()
+                            {
+                                return this->radio;
+                            }
+
+                        protected:
+                            /**
+                             * Retries count by profile level
+                             */
+                            static unsigned char getRetries(unsigned char level)
+                            {
+                                static unsigned char const retries[LINK_LEVELS] = {3, 5, 10, 15};
+
+                                return retries[level];
+                            }
+
+                            /**
+                             * Retries delay (x250us + 250us) by profile level
+                             */
+                            static unsigned char getRetriesDelay(unsigned char level)
+                            {
+                                static unsigned char const delays[LINK_LEVELS] = {1, 3, 5, 15};
+
+                                return delays[level];
+                            }
+
+                            /**
+                             * PA level by profile level
+                             */
+                            static rf24_pa_dbm_e getPALevel(unsigned char level)
+                            {
+                                static rf24_pa_dbm_e const levels[LINK_LEVELS] = {RF24_PA_LOW, RF24_PA_HIGH, RF24_PA_MAX, RF24_PA_MAX};
+
+                                return levels[level];
+                            }
+
+                            /**
+                             * Apply retries and PA level of current profile
+                             */
+                            void applyLevel()
+                            {
+                                this->radio->setRetries(LinkMonitor::getRetriesDelay(this->level), LinkMonitor::getRetries(this->level));
+                                this->radio->setPALevel(LinkMonitor::getPALevel(this->level));
+                            }
+
+                            /**
+                             * Compute window statistics and adapt profile
+                             */
+                            void closeWindow()
+                            {
+                                this->ackRate = (unsigned int) this->windowAcked * 100 / this->windowSamples;
+                                this->averageRetries = (unsigned int) this->windowRetries * 10 / this->windowSamples;
+                                this->carrierRate = this->windowCarrierSamples > 0 ?
+                                    (unsigned int) this->windowCarrier * 100 / this->windowCarrierSamples :
+                                    0;
+
+                                // Adapt profile
+                                unsigned char previousLevel = this->level;
+                                if (this->ackRate >= LINK_GOOD_ACK_RATE && this->averageRetries < 5 && this->level > 0) {
+                                    this->level--;
+                                } else if (this->ackRate < LINK_BAD_ACK_RATE && this->level < LINK_LEVELS - 1) {
+                                    this->level++;
+                                }
+                                if (this->level != previousLevel) {
+                                    this->applyLevel();
+                                    this->reportPending = true;
+                                }
+
+                                // Most robust profile not enough: request channel hop to master
+                                if (
+                                    this->hoppingEnabled &&
+                                    !this->hopRequested &&
+                                    this->level == LINK_LEVELS - 1 &&
+                                    this->ackRate < LINK_HOP_ACK_RATE
+                                ) {
+                                    this->hopRequested = true;
+                                    this->reportPending = true;
+                                }
+
+                                // Link lost: return to default channel and data rate (rendezvous with master)
+                                this->lostWindows = this->ackRate == 0 ? this->lostWindows + 1 : 0;
+                                if (this->lostWindows >= LINK_FALLBACK_WINDOWS) {
+                                    this->radio->setChannel(this->defaultChannel);
+                                    this->radio->setDataRate(this->defaultDataRate);
+                                    this->hopRequested = false;
+                                    this->lostWindows = 0;
+                                }
+
+                                // Periodic report
+                                if (++this->windowCount >= LINK_REPORT_WINDOWS) {
+                                    this->windowCount = 0;
+                                    this->reportPending = true;
+                                }
+
+                                this->windowSamples = 0;
+                                this->windowAcked = 0;
+                                this->windowRetries = 0;
+                                this->windowCarrier = 0;
+                                this->windowCarrierSamples = 0;
+                                this->stallLoops = 0;
+                                this->stalled = false;
+                            }
+
+                            /**
+                             * Radio
+                             */
+                            RF24 * radio = NULL;
+
+                            /**
+                             * Default channel (rendezvous)
+                             */
+                            unsigned char defaultChannel = 76;
+
+                            /**
+                             * Default data rate (rendezvous)
+                             */
+                            rf24_datarate_e defaultDataRate = RF24_1MBPS;
+
+                            /**
+                             * Current profile level (0: excellent), most robust at boot
+                             */
+                            unsigned char level = LINK_LEVELS - 1;
+
+                            /**
+                             * Window counters
+                             */
+                            unsigned char windowSamples = 0;
+                            unsigned char windowAcked = 0;
+                            unsigned int windowRetries = 0;
+                            unsigned int windowCarrier = 0;
+                            unsigned int windowCarrierSamples = 0;
+
+                            /**
+                             * Number of windows since last periodic report
+                             */
+                            unsigned char windowCount = 0;
+
+                            /**
+                             * Consecutive windows without any ack
+                             */
+                            unsigned char lostWindows = 0;
+
+                            /**
+                             * Last window statistics
+                             */
+                            unsigned char ackRate = 100;
+                            unsigned char averageRetries = 0;
+                            unsigned char carrierRate = 0;
+
+                            /**
+                             * Loops since last window closed
+                             */
+                            unsigned int stallLoops = 0;
+
+                            /**
+                             * Flag to indicate if monitor is stalled (no window closed for LINK_STALL_LOOPS loops)
+                             */
+                            bool stalled = false;
+
+                            /**
+                             * Flag to indicate if a report is pending
+                             */
+                            bool reportPending = false;
+
+                            /**
+                             * Flag to indicate if channel hop can be requested
+                             */
+                            bool hoppingEnabled = false;
+
+                            /**
+                             * Flag to indicate if a channel hop has been requested to master
+                             */
+                            bool hopRequested = false;
+                        };
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_LINKMONITOR_H
@@ -0,0 +1,171 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_OVERCURRENTPROTECTION_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_OVERCURRENTPROTECTION_H
+
+#include <Arduino.h>
+#include <com/osteres/automation/actuator/timeswitch/PowerControl.h>
+
+using com::osteres::automation::actuator::timeswitch::PowerControl;
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    namespace component
+                    {
+                        /**
+                         * Power control tripped by analog comparator interrupt
+                         * Note: header must be included from a single translation unit (sketch)
+                         */
+                        static PowerControl * volatile overcurrentPowerControl = NULL;
+
+                        /**
+                         * Overcurrent fast path using analog comparator
+                         * - AIN0 (D6): current sensor output (in parallel with analog input)
+                         * - AIN1 (D7): reference voltage set by divider, depends on sensor orientation:
+                         *   - falling (default, as PowerControl::readCurrent(): load current pulls sensor below Vcc/2):
+                         *     reference = Vcc/2 - limit (A) * ACS712_RAPPORT, trip when AIN0 falls below AIN1
+                         *   - rising (sensor wired the other way): reference = Vcc/2 + limit (A) * ACS712_RAPPORT,
+                         *     trip when AIN0 rises above AIN1
+                         * Comparator interrupt cuts output within microseconds, without waiting loop.
+                         */
+                        class OvercurrentProtection
+                        {
+                        public:
+                            /**
+                             * Constructor
+                             */
+                            OvercurrentProtection(PowerControl * powerControl)
+                            {
+                                this->powerControl = powerControl;
+                            }
+
+                            /**
+                             * Destructor
+                             */
+                            virtual ~OvercurrentProtection()
+                            {
+                                this->stop();
+                            }
+
+                            /**
+                             * Start comparator (only if enabled: AIN0/AIN1 must be wired, floating inputs trip randomly)
+                             */
+                            void setup()
+                            {
+                                if (!this->isEnabled()) {
+                                    return;
+                                }
+
+                                overcurrentPowerControl = this->powerControl;
+
+                                // Digital input buffers off on AIN0/AIN1
+                                DIDR1 |= _BV(AIN1D) | _BV(AIN0D);
+
+                                // Comparator enabled (ACD = 0), AIN0 vs AIN1, edge falling (AIN0 < AIN1) or rising (AIN0 > AIN1)
+                                // Edge bits changed with interrupt disabled, then pending flag cleared, then interrupt enabled (datasheet)
+                                unsigned char edge = this->isFalling() ? _BV(ACIS1) : _BV(ACIS1) | _BV(ACIS0);
+                                ACSR = edge;
+                                ACSR = edge | _BV(ACI);
+                                ACSR = edge | _BV(ACIE);
+
+                                // Already beyond limit: no edge to come
+                                this->check();
+                            }
+
+                            /**
+                             * Trip fault if current is beyond limit (level), called from loop.
+                             * Catch overcurrent whose edge was ignored during power on blanking
+                             */
+                            void check()
+                            {
+                                if (!this->isEnabled()) {
+                                    return;
+                                }
+
+                                bool above = (ACSR & _BV(ACO)) != 0;
+                                if (above != this->isFalling()) {
+                                    this->powerControl->tripFault(PowerControl::FAULT_COMPARATOR);
+                                }
+                            }
+
+                            /**
+                             * Stop comparator
+                             */
+                            void stop()
+                            {
+                                ACSR = _BV(ACD);
+                                overcurrentPowerControl = NULL;
+                            }
+
+                            /**
+                             * Flag to indicate if comparator protection is enabled
+                             */
+                            bool isEnabled()
+                            {
+                                return this->enabled;
+                            }
+
+                            /**
+                             * Set flag to indicate if comparator protection is enabled
+                             */
+                            void setEnabled(bool enabled)
+                            {
+                                this->enabled = enabled;
+                            }
+
+                            /**
+                             * Flag to indicate if sensor output falls below Vcc/2 with load current
+                             */
+                            bool isFalling()
+                            {
+                                return this->falling;
+                            }
+
+                            /**
+                             * Set flag to indicate if sensor output falls below Vcc/2 with load current (see wiring)
+                             */
+                            void setFalling(bool falling)
+                            {
+                                this->falling = falling;
+                            }
+
+                        protected:
+                            /**
+                             * Power control component
+                             */
+                            PowerControl * powerControl = NULL;
+
+                            /**
+                             * Flag to indicate if comparator protection is enabled
+                             */
+                            bool enabled = false;
+
+                            /**
+                             * Flag to indicate if sensor output falls below Vcc/2 with load current
+                             */
+                            bool falling = true;
+                        };
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Analog comparator interrupt: overcurrent
+ */
+ISR(ANALOG_COMP_vect)
+{
+    if (com::osteres::automation::actuator::timeswitch::component::overcurrentPowerControl != NULL) {
+        com::osteres::automation::actuator::timeswitch::component::overcurrentPowerControl->tripFault(PowerControl::FAULT_COMPARATOR);
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_OVERCURRENTPROTECTION_H
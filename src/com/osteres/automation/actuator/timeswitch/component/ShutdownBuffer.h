@@ -0,0 +1,89 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_SHUTDOWNBUFFER_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_SHUTDOWNBUFFER_H
+
+#include <Arduino.h>
+#include <com/osteres/automation/arduino/component/DataBuffer.h>
+
+using com::osteres::automation::arduino::component::DataBuffer;
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    namespace component
+                    {
+                        /**
+                         * Shutdown buffer able to give remaining time and to resume it after a reset
+                         */
+                        class ShutdownBuffer : public DataBuffer
+                        {
+                        public:
+                            /**
+                             * Constructor
+                             */
+                            ShutdownBuffer(unsigned long bufferDelay) : DataBuffer(bufferDelay)
+                            {
+                                this->bufferDelay = bufferDelay;
+                                this->resetTime = millis();
+                            }
+
+                            /**
+                             * Reset buffer with full delay
+                             */
+                            void reset()
+                            {
+                                this->setBufferDelay(this->bufferDelay);
+                                DataBuffer::reset();
+                                this->resetTime = millis();
+                            }
+
+                            /**
+                             * Restart buffer with only remaining time (when resuming after a reset)
+                             */
+                            void resume(unsigned long remaining)
+                            {
+                                if (remaining > this->bufferDelay) {
+                                    remaining = this->bufferDelay;
+                                }
+
+                                // Buffer delay restored to full delay on next reset
+                                this->setBufferDelay(remaining);
+                                DataBuffer::reset();
+                                this->resetTime = millis() - (this->bufferDelay - remaining);
+                            }
+
+                            /**
+                             * Get remaining time before buffer is outdated (in ms)
+                             */
+                            unsigned long getRemaining()
+                            {
+                                unsigned long elapsed = millis() - this->resetTime;
+
+                                return elapsed >= this->bufferDelay ? 0 : this->bufferDelay - elapsed;
+                            }
+
+                        protected:
+                            /**
+                             * Full buffer delay (in ms)
+                             */
+                            unsigned long bufferDelay = 0;
+
+                            /**
+                             * Time of last reset (in ms, millis() base)
+                             */
+                            unsigned long resetTime = 0;
+                        };
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_SHUTDOWNBUFFER_H
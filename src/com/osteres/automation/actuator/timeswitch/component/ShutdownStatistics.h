@@ -0,0 +1,240 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_SHUTDOWNSTATISTICS_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_SHUTDOWNSTATISTICS_H
+
+#define SHUTDOWN_HISTOGRAM_BINS 16 // Number of bins (last one for longer shutdown)
+#define SHUTDOWN_HISTOGRAM_BIN_WIDTH 4000 // Bin width (ms)
+#define SHUTDOWN_HISTOGRAM_PACKS 4 // Stored properties, 4 bins (1 byte each) packed by property
+#define SHUTDOWN_MIN_SAMPLES 5 // Shutdowns recorded before using distribution
+#define SHUTDOWN_SPARSE_CHECK_INTERVAL 2000 // Interval (ms) between current checks before expected completion
+
+#include <Arduino.h>
+#include <com/osteres/automation/arduino/memory/StoredProperty.h>
+
+using com::osteres::automation::arduino::memory::StoredProperty;
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    namespace component
+                    {
+                        /**
+                         * Histogram of secure shutdown durations, persisted to EEPROM
+                         * Used to check current sparsely early in shutdown and to detect abnormally long shutdown
+                         */
+                        class ShutdownStatistics
+                        {
+                        public:
+                            /**
+                             * Constructor
+                             * Statistics take ownership of properties (configured by caller, SHUTDOWN_HISTOGRAM_PACKS items)
+                             */
+                            ShutdownStatistics(StoredProperty<unsigned long> ** properties)
+                            {
+                                for (unsigned char i = 0; i < SHUTDOWN_HISTOGRAM_PACKS; i++) {
+                                    this->properties[i] = properties[i];
+
+                                    // Erased EEPROM: empty histogram
+                                    unsigned long pack = this->properties[i]->get();
+                                    if (pack == 0xFFFFFFFF) {
+                                        pack = 0;
+                                    }
+                                    for (unsigned char j = 0; j < 4; j++) {
+                                        this->bins[i * 4 + j] = (pack >> (j * 8)) & 0xFF;
+                                    }
+                                }
+                            }
+
+                            /**
+                             * Destructor
+                             */
+                            virtual ~ShutdownStatistics()
+                            {
+                                // Remove properties
+                                for (unsigned char i = 0; i < SHUTDOWN_HISTOGRAM_PACKS; i++) {
+                                    if (this->properties[i] != NULL) {
+                                        delete this->properties[i];
+                                        this->properties[i] = NULL;
+                                    }
+                                }
+                            }
+
+                            /**
+                             * Record duration of a completed shutdown (in ms) and persist histogram
+                             */
+                            void record(unsigned long duration)
+                            {
+                                unsigned long index = duration / SHUTDOWN_HISTOGRAM_BIN_WIDTH;
+                                unsigned char bin = index < SHUTDOWN_HISTOGRAM_BINS ? index : SHUTDOWN_HISTOGRAM_BINS - 1;
+
+                                // Bin full: halve all bins (oldest shutdowns weigh less)
+                                if (this->bins[bin] == 0xFF) {
+                                    for (unsigned char i = 0; i < SHUTDOWN_HISTOGRAM_BINS; i++) {
+                                        this->bins[i] >>= 1;
+                                    }
+                                }
+                                this->bins[bin]++;
+
+                                this->lastDuration = duration;
+                                this->recordCount++;
+                                this->persist();
+                            }
+
+                            /**
+                             * Get number of shutdowns in histogram
+                             */
+                            unsigned int getCount()
+                            {
+                                unsigned int count = 0;
+                                for (unsigned char i = 0; i < SHUTDOWN_HISTOGRAM_BINS; i++) {
+                                    count += this->bins[i];
+                                }
+
+                                return count;
+                            }
+
+                            /**
+                             * Flag to indicate if enough shutdowns have been recorded to use distribution
+                             */
+                            bool isLearned()
+                            {
+                                return this->getCount() >= SHUTDOWN_MIN_SAMPLES;
+                            }
+
+                            /**
+                             * Get bin index containing given percentile
+                             */
+                            unsigned char getPercentileBin(unsigned char percent)
+                            {
+                                unsigned long target = ((unsigned long) this->getCount() * percent + 99) / 100;
+                                unsigned long cumulated = 0;
+                                for (unsigned char i = 0; i < SHUTDOWN_HISTOGRAM_BINS; i++) {
+                                    cumulated += this->bins[i];
+                                    if (cumulated >= target && cumulated > 0) {
+                                        return i;
+                                    }
+                                }
+
+                                return SHUTDOWN_HISTOGRAM_BINS - 1;
+                            }
+
+                            /**
+                             * Get duration (in ms) under which given percentile of shutdowns completed (bin upper bound)
+                             */
+                            unsigned long getPercentile(unsigned char percent)
+                            {
+                                return (unsigned long) (this->getPercentileBin(percent) + 1) * SHUTDOWN_HISTOGRAM_BIN_WIDTH;
+                            }
+
+                            /**
+                             * Get interval (in ms) before next current check, for elapsed time since shutdown request
+                             * Sparse before fastest shutdowns usually complete, every loop (0) after
+                             */
+                            unsigned long getCheckInterval(unsigned long elapsed)
+                            {
+                                if (!this->isLearned()) {
+                                    return 0;
+                                }
+
+                                // Lower bound of bin of 5th percentile
+                                unsigned long expectedEarliest = (unsigned long) this->getPercentileBin(5) * SHUTDOWN_HISTOGRAM_BIN_WIDTH;
+
+                                return elapsed + SHUTDOWN_SPARSE_CHECK_INTERVAL < expectedEarliest ? SHUTDOWN_SPARSE_CHECK_INTERVAL : 0;
+                            }
+
+                            /**
+                             * Flag to indicate if shutdown lasting elapsed time (in ms) is abnormally long (above p99)
+                             */
+                            bool isAnomaly(unsigned long elapsed)
+                            {
+                                // Last bin is open ended: no upper bound known
+                                return this->isLearned() &&
+                                    this->getPercentileBin(99) < SHUTDOWN_HISTOGRAM_BINS - 1 &&
+                                    elapsed > this->getPercentile(99);
+                            }
+
+                            /**
+                             * Get bin count
+                             */
+                            unsigned char getBin(unsigned char index)
+                            {
+                                return this->bins[index];
+                            }
+
+                            /**
+                             * Get 4 bins packed (first bin in low byte), as persisted
+                             */
+                            unsigned long getPack(unsigned char index)
+                            {
+                                unsigned long pack = 0;
+                                for (unsigned char j = 0; j < 4; j++) {
+                                    pack |= (unsigned long) this->bins[index * 4 + j] << (j * 8);
+                                }
+
+                                return pack;
+                            }
+
+                            /**
+                             * Get duration of last recorded shutdown (in ms)
+                             */
+                            unsigned long getLastDuration()
+                            {
+                                return this->lastDuration;
+                            }
+
+                            /**
+                             * Get number of shutdowns recorded since boot
+                             */
+                            unsigned int getRecordCount()
+                            {
+                                return this->recordCount;
+                            }
+
+                        protected:
+                            /**
+                             * Write changed packs to EEPROM
+                             */
+                            void persist()
+                            {
+                                for (unsigned char i = 0; i < SHUTDOWN_HISTOGRAM_PACKS; i++) {
+                                    unsigned long pack = this->getPack(i);
+                                    if (this->properties[i]->get() != pack) {
+                                        this->properties[i]->set(pack);
+                                    }
+                                }
+                            }
+
+                            /**
+                             * Histogram properties (EEPROM)
+                             */
+                            StoredProperty<unsigned long> * properties[SHUTDOWN_HISTOGRAM_PACKS];
+
+                            /**
+                             * Histogram bins
+                             */
+                            unsigned char bins[SHUTDOWN_HISTOGRAM_BINS];
+
+                            /**
+                             * Duration of last recorded shutdown (in ms)
+                             */
+                            unsigned long lastDuration = 0;
+
+                            /**
+                             * Number of shutdowns recorded since boot
+                             */
+                            unsigned int recordCount = 0;
+                        };
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_SHUTDOWNSTATISTICS_H
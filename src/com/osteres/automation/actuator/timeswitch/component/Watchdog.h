@@ -0,0 +1,197 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_WATCHDOG_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_WATCHDOG_H
+
+#define WATCHDOG_RESET_CAUSE_UNKNOWN 0xFF // Reset cause cleared by bootloader and not passed to sketch
+
+#include <Arduino.h>
+#include <avr/wdt.h>
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    namespace component
+                    {
+                        /**
+                         * Reset cause (MCUSR) captured before startup code, kept out of .bss initialization
+                         */
+                        static unsigned char watchdogResetCause __attribute__ ((section (".noinit")));
+
+                        /**
+                         * Stage last entered (survive reset)
+                         */
+                        static unsigned char watchdogActiveStage __attribute__ ((section (".noinit")));
+
+                        /**
+                         * Capture reset cause and disable watchdog as early as possible (avoid reset loop until boot starts it).
+                         * Bootloader may clear MCUSR itself: its value is read from r2 only if bootloader is known to pass it
+                         * (WATCHDOG_BOOTLOADER_R2, CMake option), otherwise cause is unknown.
+                         * Note: header must be included from a single translation unit (sketch)
+                         */
+                        static void watchdogCaptureResetCause() __attribute__ ((naked, used, section (".init3")));
+                        static void watchdogCaptureResetCause()
+                        {
+#ifdef WATCHDOG_BOOTLOADER_R2
+                            __asm__ __volatile__ ("sts %0, r2" : "=m" (watchdogResetCause));
+#else
+                            watchdogResetCause = WATCHDOG_RESET_CAUSE_UNKNOWN;
+#endif
+
+                            if (MCUSR != 0) {
+                                watchdogResetCause = MCUSR;
+                            }
+                            MCUSR = 0;
+                            wdt_disable();
+                        }
+
+                        /**
+                         * Hardware watchdog fed only when all supervised stages have checked in
+                         */
+                        class Watchdog
+                        {
+                        public:
+                            /**
+                             * Stage: measure real state of output
+                             */
+                            static unsigned char const STAGE_MEASURE = 0x01;
+
+                            /**
+                             * Stage: radio transmission (send and listen)
+                             */
+                            static unsigned char const STAGE_RADIO = 0x02;
+
+                            /**
+                             * Stage: power control (lock power on, auto mode)
+                             */
+                            static unsigned char const STAGE_CONTROL = 0x04;
+
+                            /**
+                             * Stage: report state to master
+                             */
+                            static unsigned char const STAGE_REPORT = 0x08;
+
+                            /**
+                             * Stage: boot (radio and application setup)
+                             */
+                            static unsigned char const STAGE_BOOT = 0x10;
+
+                            /**
+                             * Stage: between supervised stages (serial log, loop delay)
+                             */
+                            static unsigned char const STAGE_IDLE = 0x20;
+
+                            /**
+                             * Constructor
+                             * stages: mask of stages which must check in before feeding watchdog
+                             * timeout: watchdog timeout (WDTO_xxx constant)
+                             */
+                            Watchdog(unsigned char stages, unsigned char timeout)
+                            {
+                                this->stages = stages;
+                                this->timeout = timeout;
+
+                                // Stage of previous run, only meaningful after watchdog reset
+                                this->lastStage = this->isWatchdogReset() ? watchdogActiveStage : 0;
+                                watchdogActiveStage = 0;
+                            }
+
+                            /**
+                             * Start watchdog at beginning of boot, before radio setup
+                             */
+                            void boot()
+                            {
+                                this->enter(Watchdog::STAGE_BOOT);
+                                wdt_enable(this->timeout);
+                            }
+
+                            /**
+                             * Boot done: supervise process stages
+                             */
+                            void setup()
+                            {
+                                wdt_enable(this->timeout);
+                                this->alive = 0;
+                                this->enter(Watchdog::STAGE_IDLE);
+                            }
+
+                            /**
+                             * Mark stage as active (kept across reset to locate a hang)
+                             */
+                            void enter(unsigned char stage)
+                            {
+                                watchdogActiveStage = stage;
+                            }
+
+                            /**
+                             * Mark stage(s) as alive and leave active stage. Watchdog is fed when all stages are alive
+                             */
+                            void checkIn(unsigned char stage)
+                            {
+                                watchdogActiveStage = Watchdog::STAGE_IDLE;
+                                this->alive |= stage;
+
+                                if ((this->alive & this->stages) == this->stages) {
+                                    wdt_reset();
+                                    this->alive = 0;
+                                }
+                            }
+
+                            /**
+                             * Get reset cause (MCUSR flags: PORF, EXTRF, BORF, WDRF, WATCHDOG_RESET_CAUSE_UNKNOWN if unknown)
+                             */
+                            unsigned char getResetCause()
+                            {
+                                return watchdogResetCause;
+                            }
+
+                            /**
+                             * Flag to indicate if last reset was done by watchdog
+                             */
+                            bool isWatchdogReset()
+                            {
+                                return watchdogResetCause != WATCHDOG_RESET_CAUSE_UNKNOWN && (watchdogResetCause & _BV(WDRF)) != 0;
+                            }
+
+                            /**
+                             * Get stage active when watchdog reset occurred (0 if not a watchdog reset)
+                             */
+                            unsigned char getLastStage()
+                            {
+                                return this->lastStage;
+                            }
+
+                        protected:
+                            /**
+                             * Mask of supervised stages
+                             */
+                            unsigned char stages = 0;
+
+                            /**
+                             * Mask of stages alive since last feed
+                             */
+                            unsigned char alive = 0;
+
+                            /**
+                             * Watchdog timeout (WDTO_xxx constant)
+                             */
+                            unsigned char timeout = WDTO_8S;
+
+                            /**
+                             * Stage active at watchdog reset
+                             */
+                            unsigned char lastStage = 0;
+                        };
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_COMPONENT_WATCHDOG_H
@@ -0,0 +1,72 @@
+#ifndef COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_TRANSMISSION_MONITOREDREQUESTER_H
+#define COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_TRANSMISSION_MONITOREDREQUESTER_H
+
+#include <Arduino.h>
+#include <RF24/RF24.h>
+#include <com/osteres/automation/arduino/transmission/ArduinoRequester.h>
+#include <com/osteres/automation/transmission/packet/Packet.h>
+#include <com/osteres/automation/actuator/timeswitch/component/LinkMonitor.h>
+
+using com::osteres::automation::arduino::transmission::ArduinoRequester;
+using com::osteres::automation::transmission::packet::Packet;
+using com::osteres::automation::actuator::timeswitch::component::LinkMonitor;
+
+namespace com
+{
+    namespace osteres
+    {
+        namespace automation
+        {
+            namespace actuator
+            {
+                namespace timeswitch
+                {
+                    namespace transmission
+                    {
+                        /**
+                         * Requester recording result of each packet sent (ack, retries) to link monitor
+                         */
+                        class MonitoredRequester : public ArduinoRequester
+                        {
+                        public:
+                            /**
+                             * Constructor
+                             */
+                            MonitoredRequester(RF24 * radio, uint64_t writingChannel, LinkMonitor * linkMonitor) :
+                                ArduinoRequester(radio, writingChannel)
+                            {
+                                this->radio = radio;
+                                this->linkMonitor = linkMonitor;
+                            }
+
+                            /**
+                             * Send packet, then record write result and retries of this packet (ARC)
+                             */
+                            virtual bool send(Packet * packet)
+                            {
+                                bool acked = ArduinoRequester::send(packet);
+
+                                this->linkMonitor->recordSend(acked, this->radio->getARC());
+
+                                return acked;
+                            }
+
+                        protected:
+                            /**
+                             * Radio
+                             */
+                            RF24 * radio = NULL;
+
+                            /**
+                             * Radio link monitor
+                             */
+                            LinkMonitor * linkMonitor = NULL;
+                        };
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif //COM_OSTERES_AUTOMATION_ACTUATOR_TIMESWITCH_TRANSMISSION_MONITOREDREQUESTER_H